@@ -0,0 +1,48 @@
+#!/bin/bash
+# Build the interpreter as a host console program
+# usage: build.sh <output> [NAME=VALUE ...]
+#   NAME=VALUE overrides a #define of basic_config.h, basic_config.hpp or
+#   HAL_config.h, PROGSIZE=n sets the program memory size (16384).
+#   SRC=<dir> builds another source tree, e.g. a git worktree of an older
+#   commit, instead of ../terminal-basic
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+out=$1; shift
+src=${SRC:-$here/../terminal-basic}
+d=$(mktemp -d)
+trap 'rm -rf "$d"' EXIT
+cp -r "$src"/. "$d"; rm -rf "$d/sys"
+progsize=16384
+for kv in "$@"; do
+	n=${kv%%=*}; v=${kv#*=}
+	if [ "$n" = PROGSIZE ]; then progsize=$v; continue; fi
+	grep -q -E "^[[:space:]]*#[[:space:]]*define[[:space:]]+$n[[:space:]]" \
+	    "$d/basic_config.h" "$d/basic_config.hpp" "$d/HAL_config.h" ||
+	    { echo "unknown option $n" >&2; exit 1; }
+	sed -i -E "s/^([[:space:]]*#[[:space:]]*define[[:space:]]+$n)[[:space:]]+[^/]*/\1 $v /" \
+	    "$d/basic_config.h" "$d/basic_config.hpp" "$d/HAL_config.h"
+done
+sed -i -E "s/^const pointer_t PROGRAMSIZE = 1024;/const pointer_t PROGRAMSIZE = $progsize;/" \
+    "$d/config_arduino.hpp"
+CF="-DARDUINO=100 -I$here/host -I$d -O2 -w"
+objs=()
+for f in "$d"/*.c; do
+	gcc -std=gnu11 $CF -c -o "$f.o" "$f" & objs+=("$f.o")
+done
+for f in "$d"/*.cpp "$d/terminal-basic.ino" "$here/host/hal_host.cpp" \
+    "$here/host/main.cpp"; do
+	case $(basename "$f") in
+	HAL_*.cpp|basic_arduinoio.cpp|basic_gfx.cpp|tvoutprint.cpp|\
+	liquidcrystalprint.cpp|seriallight.cpp|buffered_terminal.cpp)
+		continue;;
+	esac
+	o=$d/$(basename "$f").o
+	g++ -std=gnu++11 $CF -x c++ -c -o "$o" "$f" & objs+=("$o")
+done
+fail=0
+for job in $(jobs -p); do wait $job || fail=1; done
+[ $fail = 0 ] || exit 1
+g++ -o "$out" "${objs[@]}" -lm
+# Options of the build, for check.sh
+: > "$out.opts"
+for opt in "$@"; do echo "$opt" >> "$out.opts"; done
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Run the regression programs and compare the output with the expected one
+# usage: check.sh <binary>
+here=$(cd "$(dirname "$0")" && pwd)
+shopt -s nullglob
+rc=0
+fsroot=$(mktemp -d)
+trap 'rm -rf "$fsroot"' EXIT
+for t in "$here"/tests/*.bas; do
+	# Test runs on the binary built with each option of its .opts file
+	# and without each !option
+	skip=0
+	if [ -f "${t%.bas}.opts" ]; then
+		while read -r o; do
+			case $o in
+			!*) grep -qxF -- "${o#!}" "$1.opts" 2>/dev/null && skip=1 ;;
+			*) grep -qxF -- "$o" "$1.opts" 2>/dev/null || skip=1 ;;
+			esac
+		done < "${t%.bas}.opts"
+	fi
+	if [ $skip = 1 ]; then
+		echo "skip $(basename "$t")"; continue
+	fi
+	# Every test starts with the files of tests/fs
+	rm -rf "$fsroot"/*
+	cp "$here"/tests/fs/* "$fsroot"
+	if TB_FSROOT=$fsroot "$1" < "$t" 2>&1 | cmp -s - "${t%.bas}.out"; then
+		echo "ok   $(basename "$t")"
+	else
+		echo "FAIL $(basename "$t")"; rc=1
+	fi
+done
+exit $rc
@@ -0,0 +1,27 @@
+#ifndef STUB_ARDUINO_H
+#define STUB_ARDUINO_H
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <avr/pgmspace.h>
+#ifdef __cplusplus
+#include "Print.h"
+#include "Stream.h"
+#include "Printable.h"
+#endif
+#define HIGH 1
+#define LOW 0
+#ifdef __cplusplus
+extern "C" {
+#endif
+void delay(unsigned long);
+static inline void digitalWrite(int, int) {}
+#ifdef __cplusplus
+}
+template <typename A, typename B> static inline A min(A a, B b) { return a < (A)b ? a : (A)b; }
+template <typename A, typename B> static inline A max(A a, B b) { return a > (A)b ? a : (A)b; }
+#endif
+#endif
@@ -0,0 +1,2 @@
+#include "Stream.h"
+class HardwareSerial : public Stream {};
@@ -0,0 +1,33 @@
+#ifndef STUB_PRINT_H
+#define STUB_PRINT_H
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "Printable.h"
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+class Print {
+public:
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *b, size_t n) { size_t r=0; while (n--) r += write(*b++); return r; }
+	size_t write(const char *s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+	size_t print(const char *s) { return write(s); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(long n, int base = DEC) { char b[40]; if (base==16) snprintf(b,40,"%lX",n); else snprintf(b,40,"%ld",n); return write(b); }
+	size_t print(unsigned long n, int base = DEC) { char b[40]; if (base==16) snprintf(b,40,"%lX",n); else snprintf(b,40,"%lu",n); return write(b); }
+	size_t print(int n, int base = DEC) { return print((long)n, base); }
+	size_t print(unsigned n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t print(short n, int base = DEC) { return print((long)n, base); }
+	size_t print(unsigned short n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t print(double d, int digits = 2) { char b[64]; snprintf(b,64,"%.*f",digits,d); return write(b); }
+	size_t print(const Printable &p) { return p.printTo(*this); }
+	size_t println() { return write((const uint8_t*)"\r\n", 2); }
+	template <typename T> size_t println(const T &v) { size_t r = print(v); return r + println(); }
+	template <typename T> size_t println(const T &v, int b) { size_t r = print(v, b); return r + println(); }
+	virtual void flush() {}
+};
+#endif
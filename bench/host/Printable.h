@@ -0,0 +1,6 @@
+#ifndef STUB_PRINTABLE_H
+#define STUB_PRINTABLE_H
+#include <stddef.h>
+class Print;
+class Printable { public: virtual size_t printTo(Print&) const = 0; };
+#endif
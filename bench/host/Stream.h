@@ -0,0 +1,13 @@
+#ifndef STUB_STREAM_H
+#define STUB_STREAM_H
+#include "Print.h"
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	void setTimeout(unsigned long) {}
+	size_t readBytes(uint8_t *b, size_t n) { size_t i=0; while (i<n && available()>0) b[i++] = read(); return i; }
+	size_t readBytes(char *b, size_t n) { return readBytes((uint8_t*)b, n); }
+};
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Host HAL for running the interpreter as a console program: the whole
+ * standard input is read at start, the program exits when it is consumed.
+ * NVRAM is kept in memory, external memory files in $TB_FSROOT
+ */
+
+#include "HAL.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static std::vector<uint8_t> g_in;
+static size_t g_inpos = 0;
+static bool g_gate = false;
+static uint8_t g_nvram[65536];
+
+extern "C" {
+void delay(unsigned long) {}
+void HAL_initialize()
+{
+	int c;
+	while ((c = getchar()) != EOF) g_in.push_back(c == '\n' ? '\r' : c);
+}
+void HAL_finalize() {}
+void HAL_update() {}
+HAL_nvram_address_t HAL_nvram_getsize() { return sizeof(g_nvram); }
+void HAL_nvram_write(HAL_nvram_address_t a, uint8_t b) { g_nvram[a] = b; }
+uint8_t HAL_nvram_read(HAL_nvram_address_t a) { return g_nvram[a]; }
+void HAL_terminal_write(HAL_terminal_t, uint8_t b)
+{
+	if (getenv("TB_QUIET") == NULL) putchar(b);
+}
+uint8_t HAL_terminal_read(HAL_terminal_t) { uint8_t c = g_in[g_inpos++]; if (c == '\r') g_gate = false; return c; }
+BOOLEAN HAL_terminal_isdataready(HAL_terminal_t) { return g_gate && g_inpos < g_in.size(); }
+void HAL_time_sleep_ms(uint32_t)
+{
+	if (g_inpos >= g_in.size()) { fflush(stdout); exit(0); }
+	g_gate = true;
+}
+uint32_t HAL_time_gettime_ms()
+{
+	struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000u + ts.tv_nsec / 1000000u;
+}
+void HAL_random_seed(uint32_t s) { srand(s); }
+uint32_t HAL_random_generate(uint32_t m) { return rand() % m; }
+}
+
+#if HAL_EXTMEM
+#include <dirent.h>
+#include <string>
+static FILE *g_files[8];
+static std::string fpath(const char *n)
+{
+	// Files live in $TB_FSROOT, ./fsroot by default
+	const char *root = getenv("TB_FSROOT");
+	std::string s = root != NULL ? root : "fsroot";
+	if (*n == '/') ++n;
+	return s + "/" + n;
+}
+HAL_extmem_file_t HAL_extmem_openfile(const char p[13])
+{
+	for (int i = 1; i < 8; ++i) if (!g_files[i]) {
+		FILE *f = fopen(fpath(p).c_str(), "r+b");
+		if (!f) f = fopen(fpath(p).c_str(), "w+b");
+		if (!f) return 0;
+		g_files[i] = f; return i;
+	}
+	return 0;
+}
+void HAL_extmem_deletefile(const char p[13]) { remove(fpath(p).c_str()); }
+void HAL_extmem_closefile(HAL_extmem_file_t h) { if (g_files[h]) fclose(g_files[h]); g_files[h] = 0; }
+uint8_t HAL_extmem_readfromfile(HAL_extmem_file_t h) { int c = fgetc(g_files[h]); return c < 0 ? 0 : c; }
+void HAL_extmem_writetofile(HAL_extmem_file_t h, uint8_t b) { fputc(b, g_files[h]); }
+HAL_extmem_fileposition_t HAL_extmem_getfileposition(HAL_extmem_file_t h) { return ftell(g_files[h]); }
+void HAL_extmem_setfileposition(HAL_extmem_file_t h, HAL_extmem_fileposition_t p) { fseek(g_files[h], p, SEEK_SET); }
+HAL_extmem_fileposition_t HAL_extmem_getfilesize(HAL_extmem_file_t h) { long p = ftell(g_files[h]); fseek(g_files[h], 0, SEEK_END); long s = ftell(g_files[h]); fseek(g_files[h], p, SEEK_SET); return s; }
+uint32_t HAL_extmem_getfreespace() { return 1000000; }
+uint16_t HAL_extmem_getnumfiles() { return 0; }
+void HAL_extmem_getfilename(uint16_t, char n[13]) { n[0] = 0; }
+BOOLEAN HAL_extmem_fileExists(const char p[13]) { FILE *f = fopen(fpath(p).c_str(), "rb"); if (f) fclose(f); return f != 0; }
+#endif
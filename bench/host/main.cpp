@@ -0,0 +1,3 @@
+void setup();
+void loop();
+int main() { setup(); for (;;) loop(); }
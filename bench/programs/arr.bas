@@ -0,0 +1,8 @@
+10 DIM P(10),Q(10),R(10),S(10),M(10,10)
+20 FOR K=1 TO 400
+30 FOR I=0 TO 10:FOR J=0 TO 10
+40 M(I,J)=M(J,I)+P(I)+S(J)
+50 NEXT J:NEXT I
+60 NEXT K
+70 PRINT M(5,5)
+RUN
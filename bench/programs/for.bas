@@ -0,0 +1,6 @@
+10 FOR I=1 TO 300
+20 FOR J=1 TO 300:NEXT J
+30 FOR K%=1 TO 300:NEXT K%
+40 NEXT I
+50 PRINT I;J;K%
+RUN
@@ -0,0 +1,10 @@
+10 FOR K=1 TO 300
+20 D=0:GOSUB 100
+40 NEXT K
+50 PRINT D
+60 END
+100 D=D+1
+110 FOR A=1 TO 2:FOR B=1 TO 2:FOR C=1 TO 2
+120 IF D<60 THEN GOSUB 100
+130 RETURN
+RUN
@@ -0,0 +1,12 @@
+#!/bin/bash
+# Jump lookup benchmark: 300 lines before a 20000 iteration IF ... THEN loop
+# usage: goto.sh > goto.bas
+for n in $(seq 10 10 2990); do
+	echo "$n REM PAD LINE"
+done
+cat <<'END'
+3000 I%=0
+3010 I%=I%+1:IF I%<20000 THEN 3010
+3020 PRINT I%
+RUN
+END
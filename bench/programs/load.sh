@@ -0,0 +1,8 @@
+#!/bin/bash
+# Program entry benchmark: 3000 lines typed in ascending order, needs a
+# PROGSIZE=64000 build
+# usage: load.sh > load.bas
+for k in $(seq 3000); do
+	echo "$((k * 10)) A=A+$k"
+done
+echo 'PRINT "DONE"'
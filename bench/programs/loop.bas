@@ -0,0 +1,13 @@
+10 S=0
+20 FOR I=1 TO 2000
+30 FOR J=1 TO 10
+40 S=S+I*J
+50 IF S>100000 THEN S=S-100000
+60 NEXT J
+70 GOSUB 200
+80 NEXT I
+90 PRINT S
+100 END
+200 T=S/3
+210 RETURN
+RUN
@@ -0,0 +1,4 @@
+10 FOR I=1 TO 20000
+20 A=I:B=A+1:C=B*2:D=C-A
+30 NEXT I
+RUN
@@ -0,0 +1,6 @@
+10 FOR I=1 TO 20000
+20 GOSUB 100
+30 NEXT I
+40 END
+100 RETURN
+RUN
@@ -0,0 +1,5 @@
+10 I=0
+20 I=I+1:GOTO 30
+30 GOTO 40
+40 IF I<20000 GOTO 20
+RUN
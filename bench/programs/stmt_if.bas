@@ -0,0 +1,6 @@
+10 FOR I=1 TO 20000
+20 IF I>5 THEN A=1
+30 IF I<5 THEN A=2
+40 IF I=3 GOTO 50
+50 NEXT I
+RUN
@@ -0,0 +1,2 @@
+10 FOR I=1 TO 100:FOR J=1 TO 400:NEXT J:NEXT I
+RUN
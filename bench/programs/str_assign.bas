@@ -0,0 +1,7 @@
+10 A$="HELLO WORLD"
+20 FOR I=1 TO 1000000
+30 C$=A$
+50 NEXT I
+60 PRINT C$
+70 END
+RUN
@@ -0,0 +1,8 @@
+10 A$="":B$="XY"
+20 FOR I=1 TO 300000
+30 A$=B$+"ABC"+B$:C$=MID$(A$,2,4)+MID$(A$,3,2)
+40 D$=C$+C$+C$
+50 NEXT I
+60 PRINT A$;C$;D$
+70 END
+RUN
@@ -0,0 +1,31 @@
+10 AA=0:AB=1:AC=2:AD=3:AE=4:AF=5:AG=6:AH=7
+20 AI=8:AJ=9:AK=10:AL=11:AM=12:AN=13:AO=14:AP=15
+30 AQ=16:AR=17:AT=18:AU=19:AV=20:AW=21:AX=22:AY=23
+40 AZ=24:BA=25:BB=26:BC=27:BD=28:BE=29:BF=30:BG=31
+50 BH=32:BI=33:BJ=34:BK=35:BL=36:BM=37:BN=38:BO=39
+60 BP=40:BQ=41:BR=42:BS=43:BT=44:BU=45:BV=46:BW=47
+70 BX=48:BY=49:BZ=50:CA=51:CB=52:CC=53:CD=54:CE=55
+80 CF=56:CG=57:CH=58:CI=59:CJ=60:CK=61:CL=62:CM=63
+90 CN=64:CO=65:CP=66:CQ=67:CR=68:CS=69:CT=70:CU=71
+100 CV=72:CW=73:CX=74:CY=75:CZ=76:DA=77:DB=78:DC=79
+110 DD=80:DE=81:DF=82:DG=83:DH=84:DI=85:DJ=86:DK=87
+120 DL=88:DM=89:DN=90:DO=91:DP=92:DQ=93:DR=94:DS=95
+130 DT=96:DU=97:DV=98:DW=99:DX=100:DY=101:DZ=102:EA=103
+140 EB=104:EC=105:ED=106:EE=107:EF=108:EG=109:EH=110:EI=111
+150 EJ=112:EK=113:EL=114:EM=115:EN=116:EO=117:EP=118:EQ=119
+160 ER=120:ES=121:ET=122:EU=123:EV=124:EW=125:EX=126:EY=127
+170 EZ=128:FA=129:FB=130:FC=131:FD=132:FE=133:FF=134:FG=135
+180 FH=136:FI=137:FJ=138:FK=139:FL=140:FM=141:FO=142:FP=143
+190 FQ=144:FR=145:FS=146:FT=147:FU=148:FV=149:FW=150:FX=151
+200 FY=152:FZ=153:GA=154:GB=155:GC=156:GD=157:GE=158:GF=159
+210 GG=160:GH=161:GI=162:GJ=163:GK=164:GL=165:GM=166:GN=167
+220 GP=168:GQ=169:GR=170:GS=171:GT=172:GU=173:GV=174:GW=175
+230 GX=176:GY=177:GZ=178:HA=179:HB=180:HC=181:HD=182:HE=183
+240 HF=184:HG=185:HH=186:HI=187:HJ=188:HK=189:HL=190:HM=191
+250 HN=192:HO=193:HP=194:HQ=195:HR=196:HS=197:HT=198:HU=199
+260 FOR I=1 TO 3000
+270 S=AA+BZ+DX+FW+HU
+280 HU=HU+1:DX=DX+1
+290 NEXT I
+300 PRINT S
+RUN
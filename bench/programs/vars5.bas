@@ -0,0 +1,7 @@
+10 AA=0:AB=1:AC=2:AD=3:AE=4
+20 FOR I=1 TO 3000
+30 S=AA+AB+AC+AD+AE
+40 AE=AE+1:AC=AC+1
+50 NEXT I
+60 PRINT S
+RUN
@@ -0,0 +1,13 @@
+10 AA=0:AB=1:AC=2:AD=3:AE=4:AF=5:AG=6:AH=7
+20 AI=8:AJ=9:AK=10:AL=11:AM=12:AN=13:AO=14:AP=15
+30 AQ=16:AR=17:AT=18:AU=19:AV=20:AW=21:AX=22:AY=23
+40 AZ=24:BA=25:BB=26:BC=27:BD=28:BE=29:BF=30:BG=31
+50 BH=32:BI=33:BJ=34:BK=35:BL=36:BM=37:BN=38:BO=39
+60 BP=40:BQ=41:BR=42:BS=43:BT=44:BU=45:BV=46:BW=47
+70 BX=48:BY=49
+80 FOR I=1 TO 3000
+90 S=AA+AM+BA+BM+BY
+100 BY=BY+1:BA=BA+1
+110 NEXT I
+120 PRINT S
+RUN
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Best wall time of the interpreter running the program
+# usage: run.sh <binary> <program.bas> [runs]
+runs=${3:-9}; best=
+for i in $(seq "$runs"); do
+	s=$(date +%s%N)
+	TB_QUIET=1 "$1" < "$2" > /dev/null
+	e=$(date +%s%N)
+	t=$(( (e - s) / 1000 ))
+	[ -z "$best" ] || [ $t -lt $best ] && best=$t
+done
+printf '%s %s %d.%d ms\n' "$(basename "$1")" "$(basename "$2")" \
+    $((best / 1000)) $((best % 1000 / 100))
@@ -0,0 +1,8 @@
+DLOAD "OTHER"
+LIST
+RUN
+DSAVE "P1"
+NEW
+DLOAD "P1"
+LIST
+RUN
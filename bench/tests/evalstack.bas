@@ -0,0 +1,12 @@
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+PRINT ABS(-1,-2);ABS(-3)
+10 I=I+1:PRINT ABS(-1,-2);ABS(-3):IF I<10 THEN 10
+RUN
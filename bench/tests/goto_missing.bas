@@ -0,0 +1,10 @@
+10 GOSUB 35
+40 PRINT "Y"
+9000 END
+RUN
+10 IF A=0 THEN 35
+RUN
+10 GOTO 35
+RUN
+10 PRINT "X":GOTO 9000
+RUN
@@ -0,0 +1,13 @@
+10 DIM A(3):A(2)=7:B=5
+20 PRINT "ONE";A(2);B
+30 PRINT "END"
+RUN
+20 PRINT "TWO";A(2);B
+PRINT A(2);B
+20 PRINT "THREE";A(2);B
+20 PRINT "SIX";A(2);B
+PRINT A(2);B
+25 B=B+1
+LIST
+RUN
+PRINT A(2);B
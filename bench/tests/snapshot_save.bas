@@ -0,0 +1,12 @@
+10 A=A+1:PRINT A
+20 IF A<3 THEN 10
+SAVE
+RUN
+CHECKPOINT
+NEW
+LOAD
+LIST
+NEW
+RESUME
+LIST
+PRINT A
@@ -209,6 +209,12 @@ typedef enum basic_token
 	BASIC_TOKEN_C_STRING,      // 87
 #if FAST_MODULE_CALL
 	BASIC_TOKEN_COMMAND,       // 88
+#endif
+#if FAST_LINE_JUMP
+	BASIC_TOKEN_C_LINENUM,     // 89
+#endif
+#if FAST_VARIABLE_ACCESS
+	BASIC_TOKEN_VARIABLE,      // 90
 #endif
 	BASIC_TOKEN_NUM_TOKENS     // 88
 } basic_token_t;
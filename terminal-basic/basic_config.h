@@ -111,6 +111,17 @@
  */
 #define FAST_MODULE_CALL    1
 
+/*
+ * Fast GOTO, GOSUB and THEN using line address, resolved by RUN command
+ */
+#define FAST_LINE_JUMP      1
+
+/*
+ * Fast scalar variable access using variable frame address, resolved by
+ * RUN command
+ */
+#define FAST_VARIABLE_ACCESS 0
+
 /*
  * Support of integer division '\' and modulo 'MOD' operation
  */
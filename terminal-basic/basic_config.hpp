@@ -93,6 +93,12 @@
  * Implicit arrays without DIM statement
  */
 #define OPT_IMPLICIT_ARRAYS  0
+/**
+ * Short-circuit evaluation of OR and AND: right operand is scanned, but not
+ * evaluated, if the left one decides the result. Its function calls and
+ * array accesses are not executed
+ */
+#define OPT_SHORT_CIRCUIT    0
 
 #if USE_TEXTATTRIBUTES
 	/*
@@ -124,6 +130,13 @@
 #if CONF_USE_EXTMEMFS
 	// Unix-like file operations
 	#define USE_FILEOP 1
+	// DSAVE stores tokenized program image before the text, DLOAD and
+	// DCHAIN copy it, if saved with the same configuration
+	#define EXTMEMFS_IMAGE 1
+	// DRUN executes the tokenized program image from the file, keeping
+	// only variables, arrays and stack in program memory. Requires
+	// EXTMEMFS_IMAGE and CONF_LINE_CACHE
+	#define EXTMEMFS_STREAM 0
 #endif
 
 // Use text error strings
@@ -145,6 +158,26 @@
 	#endif // CONF_MODULE_ARDUINOIO_TONE
 #endif // CONF_MODULE_ARDUINOIO
 
+/*
+ * Interpreter snapshot module: CHECKPOINT and RESUME commands save and
+ * restore program memory and execution state. The snapshot is stored in
+ * the external memory file if CONF_USE_EXTMEMFS, or in NVRAM otherwise
+ */
+#define CONF_MODULE_SNAPSHOT 0
+#if CONF_MODULE_SNAPSHOT
+	/*
+	 * Snapshot address in NVRAM. SAVE uses NVRAM from 0 for its header
+	 * and up to SINGLE_PROGSIZE bytes of the program text, the snapshot
+	 * follows them. CHECKPOINT fails if NVRAM is too small for both
+	 */
+	#if USE_SAVE_LOAD
+		#define SNAPSHOT_NVRAM_ADDRESS \
+		    (sizeof(Interpreter::EEpromHeader_t) + SINGLE_PROGSIZE)
+	#else
+		#define SNAPSHOT_NVRAM_ADDRESS 0
+	#endif
+#endif // CONF_MODULE_SNAPSHOT
+
 // External EEPROM functions module
 #define USE_EXTEEPROM    0
 #if USE_EXTEEPROM
@@ -169,6 +202,221 @@
  */
 #define CONF_USE_ALIGN 0
 
+/*
+ * Program line number index. GOTO/GOSUB/THEN targets are searched by
+ * binary search in the table of line offsets instead of the linear scan.
+ * The table takes LINE_INDEX_SIZE pointers and 3 bytes of RAM
+ */
+#define CONF_LINE_INDEX 0
+#if CONF_LINE_INDEX
+	/*
+	 * Number of index entries. Programs with more lines get the sparse
+	 * index, each entry covers several lines
+	 */
+	#define LINE_INDEX_SIZE 32
+#endif // CONF_LINE_INDEX
+
+/*
+ * Gap buffer in the program text. Lines, entered or removed one after
+ * another near the same place, do not move the variables and arrays
+ */
+#define CONF_TEXT_GAP 1
+#if CONF_TEXT_GAP
+	/*
+	 * Minimal gap grow size in bytes
+	 */
+	#define TEXT_GAP_SIZE 64
+#endif // CONF_TEXT_GAP
+
+/*
+ * Lines with numbers greater then the last one are appended to the program
+ * text without the search of insertion point. Makes loading of the sorted
+ * program text linear
+ */
+#define CONF_FAST_APPEND 1
+
+/*
+ * Copy recently executed program lines to the on-chip RAM cache and parse
+ * them from there. Useful if program text is placed in the slow external
+ * memory (USE_EXTMEM)
+ */
+#define CONF_LINE_CACHE 0
+#if CONF_LINE_CACHE
+	/*
+	 * Number of the cached lines
+	 */
+	#define LINE_CACHE_SIZE 4
+	/*
+	 * Maximal size of the cached line body, longer lines are parsed
+	 * from the program memory
+	 */
+	#define LINE_CACHE_LINESIZE PROGSTRINGSIZE
+#endif
+
+/*
+ * Variable index: hash table of the variable frame addresses. Variables
+ * are found without the scan of the variables area. The table takes
+ * VARIABLE_INDEX_SIZE pointers of RAM
+ */
+#define CONF_VARIABLE_INDEX 0
+#if CONF_VARIABLE_INDEX
+	/*
+	 * Number of index entries, variables with the same name hash share
+	 * one entry
+	 */
+	#define VARIABLE_INDEX_SIZE 16
+#endif // CONF_VARIABLE_INDEX
+
+/*
+ * Array descriptor cache: frame addresses and subscript strides of the
+ * recently used arrays. Elements are accessed without the scan of the
+ * arrays area and without the subscript stack frames. Each entry takes
+ * a pointer, a byte and 4 bytes per dimension of RAM
+ */
+#define CONF_ARRAY_CACHE 0
+#if CONF_ARRAY_CACHE
+	/*
+	 * Number of cache entries, arrays with the same name hash share
+	 * one entry
+	 */
+	#define ARRAY_CACHE_SIZE 4
+	/*
+	 * Maximal number of dimensions of the cached array
+	 */
+	#define ARRAY_CACHE_DIMENSIONS 2
+#endif // CONF_ARRAY_CACHE
+
+/*
+ * FOR-loops with INTEGER or REAL variable, step and final value are
+ * iterated by NEXT with native arithmetic on the cached variable frame.
+ * Each FOR-loop stack frame grows by a pointer and 3 bytes
+ */
+#define CONF_FAST_FOR_NEXT 0
+
+/*
+ * Zero-iteration FOR-loop body is scanned for the NEXT statement once,
+ * the position after NEXT is cached and the next skips of the same loop
+ * jump there directly. Each entry takes two program positions of RAM
+ */
+#define CONF_FOR_SKIP_CACHE 0
+#if CONF_FOR_SKIP_CACHE
+	/*
+	 * Number of cached loops, loops with the same position hash share
+	 * one entry
+	 */
+	#define FOR_SKIP_CACHE_SIZE 4
+#endif // CONF_FOR_SKIP_CACHE
+
+/*
+ * Subprogram return frames are linked on the stack, RETURN drops the frames
+ * above the last one at once without walking them. Each GOSUB frame grows by
+ * one pointer: 4 -> 6 bytes on AVR, a third less nesting depth for the same
+ * stack memory. Enable on boards with RAM to spare
+ */
+#define CONF_GOSUB_LINK 0
+
+/*
+ * String stack frames and string variables are sized by the string length
+ * instead of STRING_SIZE. Variable frames grow in steps, moving the next
+ * variables and arrays, and keep their size until the variables are cleared.
+ * Each string variable takes a capacity byte, the code takes flash
+ */
+#define CONF_PACKED_STRINGS 0
+#if CONF_PACKED_STRINGS
+	/*
+	 * Capacity step of the string variable frames in bytes
+	 */
+	#define STRING_CAPACITY_STEP 8
+#endif // CONF_PACKED_STRINGS
+
+/*
+ * String array elements are stored in the pool, following the table of
+ * element offsets, instead of STRING_SIZE per element. The pool is kept
+ * compact: overwriting element moves the next elements and arrays. Such
+ * arrays are not allowed in MAT statements. The code takes flash
+ */
+#define CONF_PACKED_STRING_ARRAYS 0
+
+/*
+ * False IF and DATA statements, which were scanned to the end of the line
+ * without errors, are cached. Next executions of these statements skip the
+ * rest of the line without lexing it. Each entry takes a program position
+ * of RAM
+ */
+#define CONF_LINE_SKIP_CACHE 0
+#if CONF_LINE_SKIP_CACHE
+	/*
+	 * Number of cached statements, statements with the same position
+	 * hash share one entry
+	 */
+	#define LINE_SKIP_CACHE_SIZE 8
+#endif // CONF_LINE_SKIP_CACHE
+
+/*
+ * Program lines are checked by the parser at entry. Syntax errors are
+ * reported at once, lines without errors and without statements, which
+ * change the state even if scanned, are not scanned at run time: false
+ * IF statements and zero-iteration FOR-loops skip them. Each line header
+ * grows by a byte of the program memory
+ */
+#define CONF_LINE_CHECK 0
+
+/*
+ * Arguments and results of the built-in functions and commands are passed
+ * through the dedicated stack of value slots instead of the program memory
+ * stack frames. GOSUB, FOR, DEF FN and INPUT frames remain in the program
+ * memory. The slots take EVAL_STACK_SIZE values and a byte of RAM
+ */
+#define CONF_EVAL_STACK 0
+#if CONF_EVAL_STACK
+	/*
+	 * Number of value slots
+	 */
+	#define EVAL_STACK_SIZE 8
+#endif // CONF_EVAL_STACK
+
+/*
+ * Statements of the running program are compiled on the first execution to
+ * the stack machine code with resolved variables, constants and jump
+ * targets. Program text remains the source of LIST and SAVE, statements,
+ * which can't be compiled, are executed by the parser
+ */
+#define CONF_BYTECODE 0
+#if CONF_BYTECODE
+	/*
+	 * Number of compiled statements, even. Statements with the same
+	 * position hash share the set of two entries
+	 */
+	#define BYTECODE_CACHE_SIZE 16
+	/*
+	 * Maximal size of the statement code in bytes
+	 */
+	#define BYTECODE_SIZE 56
+	/*
+	 * Depth of the expression evaluation stack
+	 */
+	#define BYTECODE_STACK_SIZE 6
+#endif // CONF_BYTECODE
+
+/*
+ * Execution quantum: running program executes several statements per
+ * Interpreter::step() call. Input is polled for the break key once per
+ * EXEC_POLL_PERIOD statements. Takes a byte of RAM per interpreter, the
+ * other terminals wait for the whole quantum
+ */
+#define CONF_EXEC_QUANTUM 0
+#if CONF_EXEC_QUANTUM
+	/*
+	 * Default number of statements per step, changed at runtime by
+	 * Interpreter::setExecQuantum()
+	 */
+	#define EXEC_QUANTUM 16
+	/*
+	 * Number of statements between input polls
+	 */
+	#define EXEC_POLL_PERIOD 4
+#endif // CONF_EXEC_QUANTUM
+
 /*
  * GFX module
  */
@@ -26,6 +26,7 @@
 
 #include "basic_program.hpp"
 #include <assert.h>
+#include <stddef.h>
 #ifdef ARDUINO_ARCH_ESP32
 #include <pgmspace.h>
 #else
@@ -39,6 +40,9 @@ static const uint8_t sdfsCommands[] PROGMEM = {
 	'D', 'C', 'H', 'A', 'I', 'N', ASCII_NUL,
 	'D', 'I', 'R', 'E', 'C', 'T', 'O', 'R', 'Y', ASCII_NUL,
 	'D', 'L', 'O', 'A', 'D', ASCII_NUL,
+#if EXTMEMFS_STREAM
+	'D', 'R', 'U', 'N', ASCII_NUL,
+#endif
 	'D', 'S', 'A', 'V', 'E', ASCII_NUL,
 #if USE_FILEOP
 	'F', 'C', 'L', 'O', 'S', 'E', ASCII_NUL,
@@ -65,6 +69,9 @@ const FunctionBlock::function  ExtmemFSModule::_commands[] PROGMEM = {
 	ExtmemFSModule::dchain,
 	ExtmemFSModule::directory,
 	ExtmemFSModule::dload,
+#if EXTMEMFS_STREAM
+	ExtmemFSModule::drun,
+#endif
 	ExtmemFSModule::dsave,
 #if USE_FILEOP
 	ExtmemFSModule::com_fclose,
@@ -79,6 +86,35 @@ const FunctionBlock::function  ExtmemFSModule::_commands[] PROGMEM = {
 #endif
 };
 
+#if EXTMEMFS_IMAGE
+/**
+ * Header of the tokenized program image. DSAVE writes the program text,
+ * an empty line, which ends the text for the loader, then the image text
+ * and this header at the end of the file. Fields are fixed-width, so the
+ * header is found in the file of any configuration
+ */
+struct PACKED ExtmemFSModule::ImageHeader
+{
+	uint8_t magic[3];
+	uint8_t version;
+	// Image text size
+	uint32_t textSize;
+	// Configuration fingerprint
+	uint8_t language;
+	uint8_t reals;
+	uint8_t pointerSize;
+	// Checksum of the token and module command tables
+	uint16_t tokens;
+	// Program text checksum
+	uint16_t crc16;
+};
+
+static const uint8_t imageMagic[] PROGMEM = { ASCII_NUL, 'T', 'B' };
+
+// Image format version, 2 follows the program text
+static const uint8_t imageVersion = 2;
+#endif // EXTMEMFS_IMAGE
+
 #if USE_FILEOP
 const FunctionBlock::function ExtmemFSModule::_functions[] PROGMEM = {
 	ExtmemFSModule::func_fopen,
@@ -111,7 +147,7 @@ ExtmemFSModule::loadAutorun(Interpreter& i)
 		return;
 	
 	FileStream fs(f);
-	if (!_loadText(fs, i))
+	if (!_load(fs, i))
 		return;
 	
 	i.run();
@@ -282,12 +318,17 @@ ExtmemFSModule::dchain(Interpreter &i)
 	i._program.moveData(0);
 	i._program.jump(0);
 	i.stop();
-	return _loadText(fs, i);
+	return _load(fs, i);
 }
 
 bool
 ExtmemFSModule::dsave(Interpreter &i)
 {
+#if EXTMEMFS_STREAM
+	// Program text is in the file, which can be overwritten
+	if (i._program.textStorage() != nullptr)
+		return false;
+#endif
 	FileStream fs;
 
 	{ // Stack section 1
@@ -354,10 +395,197 @@ ExtmemFSModule::dsave(Interpreter &i)
 		fs.print('\n');
 	}
 	} // Stack section 2
+#if EXTMEMFS_IMAGE
+	// Text is saved anyway, image is optional
+	_saveImage(fs, i);
+#endif
 	fs.close();
 	return true;
 }
 
+bool
+ExtmemFSModule::_load(FileStream &f, Interpreter &i)
+{
+	bool result;
+#if EXTMEMFS_IMAGE
+	ImageHeader h;
+	if (_findImage(f, h, i))
+		result = _loadImage(f, h, i);
+	else {
+		// Text of the file without image of this configuration
+		f.seek(0);
+		result = _loadText(f, i);
+	}
+#else
+	result = _loadText(f, i);
+#endif // EXTMEMFS_IMAGE
+	// Loaders leave the file open on every exit path
+	f.close();
+	return result;
+}
+
+#if EXTMEMFS_IMAGE
+void
+ExtmemFSModule::imageHeader(ImageHeader &h, Interpreter &i)
+{
+	// Padding of the unpacked structure is compared too
+	memset(&h, 0, sizeof(h));
+	memcpy_P(h.magic, imageMagic, sizeof(h.magic));
+	h.version = imageVersion;
+	h.language = CONF_LEXER_LANG;
+	h.reals = USE_REALS;
+	h.pointerSize = sizeof(uintptr_t);
+
+	h.tokens = i.textFormatChecksum();
+	h.textSize = h.crc16 = 0;
+}
+
+bool
+ExtmemFSModule::_findImage(FileStream &f, ImageHeader &h, Interpreter &i)
+{
+	const HAL_extmem_fileposition_t size = f.size();
+	if (size < sizeof(h))
+		return false;
+	f.seek(size - sizeof(h));
+	for (uint8_t n = 0; n < sizeof(h); ++n)
+		reinterpret_cast<uint8_t*>(&h)[n] = f.read();
+
+	ImageHeader cur;
+	imageHeader(cur, i);
+	cur.textSize = h.textSize;
+	cur.crc16 = h.crc16;
+	if (memcmp(&h, &cur, sizeof(h)) != 0 ||
+	    h.textSize > size - sizeof(h) ||
+	    h.textSize >= i._program.programSize)
+		return false;
+	f.seek(size - sizeof(h) - h.textSize);
+	return true;
+}
+
+bool
+ExtmemFSModule::_saveImage(FileStream &f, Interpreter &i)
+{
+	Program &p = i._program;
+	p.reset();
+#if FAST_MODULE_CALL
+	// Command addresses are valid only in the current firmware
+	if (!i.relocateCommands(true)) {
+		i.relocateCommands(false);
+		return false;
+	}
+#endif
+	ImageHeader h;
+	imageHeader(h, i);
+	h.textSize = p._textEnd;
+	h.crc16 = tools_crc16_buffer(0, p._text, p._textEnd);
+	// Empty line ends the text
+	f.write('\n');
+	for (Pointer n = 0; n < p._textEnd; ++n)
+		f.write(p._text[n]);
+	for (uint8_t n = 0; n < sizeof(h); ++n)
+		f.write(reinterpret_cast<const uint8_t*>(&h)[n]);
+#if FAST_MODULE_CALL
+	i.relocateCommands(false);
+#endif
+	return true;
+}
+
+bool
+ExtmemFSModule::_loadImage(FileStream &f, const ImageHeader &h,
+    Interpreter &i)
+{
+	Program &p = i._program;
+	const Pointer textEnd = h.textSize;
+	// Variables of the chained program are moved after the new text
+	if (uint32_t(textEnd) + p._arraysEnd - p._textEnd >= p._sp)
+		return false;
+	p.moveData(textEnd);
+
+	uint16_t crc = 0;
+	for (Pointer n = 0; n < textEnd; ++n) {
+		const uint8_t b = f.read();
+		p._text[n] = b;
+		crc = tools_crc16_update(crc, b);
+	}
+
+	bool result = crc == h.crc16;
+#if FAST_MODULE_CALL
+	if (result)
+		result = i.relocateCommands(false);
+#endif
+	if (!result)
+		p.moveData(0);
+#if CONF_USE_ALIGN
+	p.alignVars(p._textEnd);
+#endif
+	p.reset();
+
+	return result;
+}
+
+#endif // EXTMEMFS_IMAGE
+
+#if EXTMEMFS_STREAM
+ExtmemFSModule::ImageStorage ExtmemFSModule::_imageStorage;
+
+bool
+ExtmemFSModule::_checkImage(FileStream &f, const ImageHeader &h)
+{
+	const Pointer textEnd = h.textSize;
+	uint16_t crc = 0;
+	Pointer next = 0;
+	for (Pointer n = 0; n < textEnd; ++n) {
+		const uint8_t b = f.read();
+		crc = tools_crc16_update(crc, b);
+		// Every line must fit the line cache
+		if (n == next + offsetof(Program::Line, size)) {
+			if (b < sizeof(Program::Line) ||
+			    b > sizeof(Program::Line) + LINE_CACHE_LINESIZE)
+				return false;
+			next += b;
+		}
+	}
+	return next == textEnd && crc == h.crc16;
+}
+
+void
+ExtmemFSModule::ImageStorage::attach(HAL_extmem_file_t f,
+    HAL_extmem_fileposition_t text, Interpreter &i)
+{
+	_file = f;
+	_text = text;
+	_interpreter = &i;
+}
+
+bool
+ExtmemFSModule::ImageStorage::readLine(
+    Pointer index,
+    Program::Line *line,
+    uint8_t size)
+{
+	HAL_extmem_setfileposition(_file, _text + index);
+	uint8_t *buf = reinterpret_cast<uint8_t*>(line);
+	for (uint8_t n = 0; n < sizeof(Program::Line); ++n)
+		buf[n] = HAL_extmem_readfromfile(_file);
+	if (line->size < sizeof(Program::Line) || line->size > size)
+		return false;
+	for (uint8_t n = sizeof(Program::Line); n < line->size; ++n)
+		buf[n] = HAL_extmem_readfromfile(_file);
+#if FAST_MODULE_CALL
+	// Image stores command numbers
+	return _interpreter->relocateCommands(*line, false);
+#else
+	return true;
+#endif
+}
+
+void
+ExtmemFSModule::ImageStorage::close()
+{
+	HAL_extmem_closefile(_file);
+}
+#endif // EXTMEMFS_STREAM
+
 bool
 ExtmemFSModule::_loadText(FileStream &f, Interpreter &i)
 {
@@ -391,7 +619,6 @@ ExtmemFSModule::_loadText(FileStream &f, Interpreter &i)
 			break;
 	}
 
-	f.close();
 	i._program.reset();
 
 	return true;
@@ -411,8 +638,41 @@ ExtmemFSModule::dload(Interpreter &i)
 	FileStream fs(f);
 	i._program.newProg();
 
-	return _loadText(fs, i);
+	return _load(fs, i);
+}
+
+#if EXTMEMFS_STREAM
+bool
+ExtmemFSModule::drun(Interpreter &i)
+{
+	char ss[16];
+	if (!getFileName(i, ss))
+		return false;
+
+	HAL_extmem_file_t f = HAL_extmem_openfile(ss);
+	if (f == 0)
+		return false;
+
+	FileStream fs(f);
+	ImageHeader h;
+	if (!_findImage(fs, h, i)) {
+		fs.close();
+		return false;
+	}
+	const HAL_extmem_fileposition_t text = fs.position();
+	if (!_checkImage(fs, h)) {
+		fs.close();
+		return false;
+	}
+
+	// Previous external program file is closed first
+	i._program.newProg();
+	_imageStorage.attach(f, text, i);
+	i._program.setTextStorage(&_imageStorage, h.textSize);
+	i.run();
+	return true;
 }
+#endif // EXTMEMFS_STREAM
 
 bool
 ExtmemFSModule::header(Interpreter &i)
@@ -50,6 +50,21 @@ public:
 		HAL_extmem_closefile(m_file);
 	}
 	
+	void seek(HAL_extmem_fileposition_t pos)
+	{
+		HAL_extmem_setfileposition(m_file, pos);
+	}
+	
+	HAL_extmem_fileposition_t position()
+	{
+		return HAL_extmem_getfileposition(m_file);
+	}
+	
+	HAL_extmem_fileposition_t size()
+	{
+		return HAL_extmem_getfilesize(m_file);
+	}
+	
 private:
 	
 	HAL_extmem_file_t m_file;
@@ -107,6 +122,9 @@ private:
 	static bool directory(Interpreter&);
 	static bool scratch(Interpreter&);
 	static bool dload(Interpreter&);
+#if EXTMEMFS_STREAM
+	static bool drun(Interpreter&);
+#endif
 	static bool header(Interpreter&);
 #if USE_FILEOP
 	static bool com_fclose(Interpreter&);
@@ -119,7 +137,67 @@ private:
 	static bool func_fread(Interpreter&);
 #endif // USE_FILEOP
 	static bool getFileName(Interpreter&, char[]);
+	static bool _load(FileStream&, Interpreter&);
 	static bool _loadText(FileStream&, Interpreter&);
+#if EXTMEMFS_IMAGE
+	struct ImageHeader;
+	/**
+	 * @brief Fill image header with the current configuration fingerprint
+	 * @param header [out]
+	 * @param interpreter
+	 */
+	static void imageHeader(ImageHeader&, Interpreter&);
+	/**
+	 * @brief Find the image of the current configuration in the file
+	 * @param file stream, positioned at the image text on success
+	 * @param header [out]
+	 * @param interpreter
+	 * @return flag of success
+	 */
+	static bool _findImage(FileStream&, ImageHeader&, Interpreter&);
+	static bool _saveImage(FileStream&, Interpreter&);
+	/**
+	 * @brief Copy program text from tokenized image
+	 * @param file stream, positioned at the image text
+	 * @param header image header
+	 * @param interpreter
+	 * @return flag of success
+	 */
+	static bool _loadImage(FileStream&, const ImageHeader&, Interpreter&);
+#endif // EXTMEMFS_IMAGE
+#if EXTMEMFS_STREAM
+	/**
+	 * @brief Check the image text, which will be executed from the file
+	 * @param file stream, positioned at the image text
+	 * @param header image header
+	 * @return flag of success
+	 */
+	static bool _checkImage(FileStream&, const ImageHeader&);
+
+	/**
+	 * @brief Program text in the tokenized image file
+	 */
+	class ImageStorage : public Program::TextStorage
+	{
+	public:
+		/**
+		 * @brief Attach the image file
+		 * @param file
+		 * @param text position of the image text in the file
+		 * @param interpreter
+		 */
+		void attach(HAL_extmem_file_t, HAL_extmem_fileposition_t,
+		    Interpreter&);
+		// TextStorage interface
+		bool readLine(Pointer, Program::Line*, uint8_t) override;
+		void close() override;
+	private:
+		HAL_extmem_file_t _file;
+		HAL_extmem_fileposition_t _text;
+		Interpreter *_interpreter;
+	};
+	static ImageStorage _imageStorage;
+#endif // EXTMEMFS_STREAM
 	
 	static const FunctionBlock::function _commands[] PROGMEM;
 #if USE_FILEOP
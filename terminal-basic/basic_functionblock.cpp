@@ -90,6 +90,47 @@ FunctionBlock::getCommandName(command c, uint8_t* buf) const
 		_next->getCommandName(c, buf);
 }
 
+#if FAST_MODULE_CALL
+bool
+FunctionBlock::getCommandIndex(command c, uint16_t &index) const
+{
+	uint8_t i = 0;
+	command wc;
+	if (commands != nullptr) {
+		while ((wc = reinterpret_cast<command>(
+		    pgm_read_ptr(&commands[i]))) != nullptr) {
+			if (wc == c) {
+				index += i;
+				return true;
+			}
+			++i;
+		}
+	}
+	index += i;
+	if (_next != nullptr)
+		return _next->getCommandIndex(c, index);
+	return false;
+}
+
+FunctionBlock::command
+FunctionBlock::getCommandByIndex(uint16_t index) const
+{
+	uint8_t i = 0;
+	command wc;
+	if (commands != nullptr) {
+		while ((wc = reinterpret_cast<command>(
+		    pgm_read_ptr(&commands[i]))) != nullptr) {
+			if (i == index)
+				return wc;
+			++i;
+		}
+	}
+	if (_next != nullptr)
+		return _next->getCommandByIndex(index - i);
+	return nullptr;
+}
+#endif // FAST_MODULE_CALL
+
 FunctionBlock::function
 FunctionBlock::_getFunction(const char *name) const
 {
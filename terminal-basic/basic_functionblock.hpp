@@ -44,6 +44,21 @@ public:
 	command getCommand(const char*) const;
 	
 	void getCommandName(command, uint8_t*) const;
+#if FAST_MODULE_CALL
+	/**
+	 * @brief Get number of the command in the chain of blocks
+	 * @param c command pointer
+	 * @param index [in/out] number of the commands in previous blocks
+	 * @return true if command was found
+	 */
+	bool getCommandIndex(command, uint16_t&) const;
+	/**
+	 * @brief Get command by it's number in the chain of blocks
+	 * @param index command number
+	 * @return command pointer or NULL if no one
+	 */
+	command getCommandByIndex(uint16_t) const;
+#endif
 	
 	void init();
 	
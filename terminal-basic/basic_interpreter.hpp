@@ -67,6 +67,41 @@ struct PACKED VariableFrame
 		return *U.i;
 	}
 
+	/**
+	 * @brief set value of the Variable frame
+	 * @param T value type
+	 * @param val value
+	 */
+	template <typename T>
+	void set(T val)
+	{
+		union
+		{
+			char *b;
+			T *i;
+		} U;
+		U.b = bytes;
+		*U.i = val;
+	}
+
+	/**
+	 * @brief string of the STRING variable frame
+	 */
+	char *string()
+	{
+#if CONF_PACKED_STRINGS
+		// String capacity byte precedes the string
+		return bytes + 1;
+#else
+		return bytes;
+#endif
+	}
+
+	const char *string() const
+	{
+		return const_cast<VariableFrame*>(this)->string();
+	}
+
 	// Variable name
 	char name[VARSIZE];
 	// Variable type
@@ -112,6 +147,44 @@ struct PACKED ArrayFrame
 		    sizeof(uint16_t) * numDimensions;
 	}
 
+	/**
+	 * @brief get string element of the STRING array
+	 * @param index element index
+	 * @return pointer to the string
+	 */
+	char *string(uint16_t index)
+	{
+#if CONF_PACKED_STRING_ARRAYS
+		// Pool follows the table of element offsets
+		return reinterpret_cast<char*>(data()) + numElements() *
+		    sizeof(uint16_t) + stringOffset(index);
+#else
+		return reinterpret_cast<char*>(data()) + STRING_SIZE * index;
+#endif
+	}
+
+	const char *string(uint16_t index) const
+	{
+		return const_cast<ArrayFrame*>(this)->string(index);
+	}
+
+#if CONF_PACKED_STRING_ARRAYS
+	/**
+	 * @brief get offset of the string element in the pool
+	 * @param index element index
+	 */
+	uint16_t stringOffset(uint16_t index) const
+	{
+		// Table is not aligned
+		return readValue<uint16_t>(data() + sizeof(uint16_t) * index);
+	}
+
+	void setStringOffset(uint16_t index, uint16_t offset)
+	{
+		writeValue(offset, data() + sizeof(uint16_t) * index);
+	}
+#endif // CONF_PACKED_STRING_ARRAYS
+
 	/**
 	 * @brief get array value by raw index
 	 * @param index shift in array data
@@ -255,6 +328,15 @@ public:
 	void init();
 	// Interpreter cycle: request a string or execute one operator
 	void step();
+#if CONF_EXEC_QUANTUM
+	/**
+	 * @brief Set the number of statements, executed by one step() call
+	 *   of the running program. Smaller quantum gives the other
+	 *   terminals more time
+	 * @param statements quantum, at least 1
+	 */
+	void setExecQuantum(uint8_t);
+#endif
 	// Execute entered command (command or inputed program line)
 	void exec();
 #if USE_DATA
@@ -375,6 +457,14 @@ public:
 	void run();
 	// goto new line
 	void gotoLine(const Parser::Value&);
+#if FAST_LINE_JUMP
+	/**
+	 * @brief jump to the line, which address was resolved by link pass
+	 * @param number line number
+	 * @param address resolved line address
+	 */
+	void gotoLine(const Parser::Value&, uint16_t);
+#endif
 	// CLear program memory
 	void newProgram();
 	/**
@@ -387,10 +477,25 @@ public:
 	Program::StackFrame *pushForLoop(const char*, uint8_t, const Parser::Value&,
 	    const Parser::Value&);
 	bool pushValue(const Parser::Value&);
+	// Push value frame to the program memory stack
+	bool pushFrameValue(const Parser::Value&);
 
 	void pushInputObject(const char*);
 
 	bool popValue(Parser::Value&);
+#if CONF_EVAL_STACK
+	// Number of values on the built-in functions stack
+	uint8_t valuesDepth() const
+	{
+		return _program._evalDepth;
+	}
+	/**
+	 * @brief drop values, left by the built-in call
+	 * @param depth stack depth before the call arguments
+	 * @return false if the call took values below this depth
+	 */
+	bool dropValues(uint8_t);
+#endif
 
 	bool popString(const char*&);
 
@@ -407,6 +512,86 @@ public:
 	 */
 	bool next(const char*);
 	bool testFor(Program::StackFrame&);
+#if CONF_FOR_SKIP_CACHE
+	/**
+	 * @brief jump after the NEXT statement of the zero-iteration loop,
+	 *   if it was found by the previous skip of this loop
+	 * @param position text position after the FOR statement
+	 * @return false if the loop body must be scanned
+	 */
+	bool skipForLoop(uint8_t);
+	/**
+	 * @brief end of the skipped loop body scan
+	 * @param position text position after the NEXT statement or 0 if
+	 *   the scan was ended by other statement
+	 */
+	void endForSkip(uint8_t);
+#endif
+#if CONF_LINE_SKIP_CACHE
+	/**
+	 * @brief Check if the false IF or DATA statement was scanned to the
+	 *   end of the line before
+	 * @param position text position after the statement keyword
+	 * @return true if the rest of the line must be skipped
+	 */
+	bool lineSkipped(uint8_t);
+	/**
+	 * @brief Cache the statement, which was scanned to the end of the line
+	 * @param position text position after the statement keyword
+	 */
+	void setLineSkip(uint8_t);
+#endif
+#if CONF_LINE_CHECK
+	/**
+	 * @brief Current program line was checked at entry and can be
+	 *   skipped without the scan
+	 */
+	bool lineChecked();
+#endif
+#if CONF_FAST_FOR_NEXT
+	/**
+	 * @brief get frame of the native FOR-loop variable
+	 * @param f loop frame body
+	 * @return variable frame or nullptr for the generic loop
+	 */
+	VariableFrame *forVariable(Program::StackFrame::ForBody&);
+	/**
+	 * @brief iterate over native loop
+	 * @param f loop frame
+	 * @param v loop variable frame
+	 * @return loop end flag
+	 */
+	bool nextNative(Program::StackFrame&, VariableFrame&);
+#endif
+#if CONF_BYTECODE
+	/**
+	 * @brief execute compiled current statement, compile it on the first
+	 *   execution
+	 * @param text statement text
+	 * @param more [out] line has more statements
+	 * @return false if statement must be executed by the parser
+	 */
+	bool runBytecode(const uint8_t*, bool&);
+	/**
+	 * @brief bytecode dispatch loop
+	 * @param code statement code
+	 * @param more [out] line has more statements
+	 * @return false if statement must be executed by the parser
+	 */
+	bool execBytecode(const uint8_t*, bool&);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief array element of the compiled statement
+	 * @param name array name
+	 * @param subscripts subscript values
+	 * @param dimensions number of subscripts
+	 * @param index [out] element index
+	 * @return array frame or nullptr if element is invalid
+	 */
+	ArrayFrame *bytecodeElement(const char*, const Parser::Value*, uint8_t,
+	    uint16_t&);
+#endif
+#endif // CONF_BYTECODE
 
 #if USE_SAVE_LOAD
 	// Internal EEPROM commands
@@ -420,6 +605,41 @@ public:
 	void load();
 	void chain();
 #endif // USE_SAVE_LOAD
+#if CONF_MODULE_SNAPSHOT
+	// Interpreter state snapshot
+	struct PACKED SnapshotHeader_t
+	{
+		uint8_t magic[3];
+		uint8_t version;
+		// Text format and memory layout fingerprint
+		uint16_t format;
+		Pointer programSize;
+		// Program memory areas
+		Pointer textEnd, variablesEnd, arraysEnd, sp;
+#if CONF_GOSUB_LINK
+		// Last subprogram return frame
+		Pointer gosubSP;
+#endif
+		// Execution state
+		uint8_t running;
+		Program::Position current;
+#if USE_DATA
+		Program::Position dataCurrent;
+		uint8_t dataParserContinue;
+#endif
+#if LOOP_INDENT
+		uint8_t loopIndent;
+#endif
+		Parser::Value result;
+		// Checksum of the header and memory areas
+		uint16_t crc16;
+	};
+	/**
+	 * @brief Get fingerprint of the snapshot format
+	 * @return checksum of the text format and memory object sizes
+	 */
+	uint16_t snapshotFormat();
+#endif // CONF_MODULE_SNAPSHOT
 	/**
 	 * @breif Input variables
 	 */
@@ -432,18 +652,49 @@ public:
 	 * @param v value to set
 	 */
 	void set(VariableFrame&, const Parser::Value&);
+#if CONF_PACKED_STRINGS
+	/**
+	 * @brief grow the STRING variable frame to hold the string
+	 * @param f variable frame
+	 * @param length string length
+	 * @return flag of success
+	 */
+	bool reserveString(VariableFrame&, uint8_t);
+#endif
 	/**
 	 * @brief set a new value and possibly create new variable
 	 * @param name variable name
 	 * @param v value to assign
 	 */
 	VariableFrame *setVariable(const char*, const Parser::Value&);
+#if FAST_VARIABLE_ACCESS
+	/**
+	 * @brief set a new value using frame address, resolved by the RUN
+	 *   command, if bindings are still valid
+	 * @param name variable name
+	 * @param v value to assign
+	 * @param address resolved frame address
+	 */
+	VariableFrame *setVariable(const char*, const Parser::Value&, uint16_t);
+#endif
 	/**
 	 * @brief setarray element a given value with indexes on the stack
 	 * @param name array name
 	 * @param value value to set
 	 */
 	void setArrayElement(const char*, const Parser::Value&);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief set array element a given value with evaluated indexes
+	 * @param name array name
+	 * @param value value to set
+	 * @param subscripts indexes, if not more then ARRAY_CACHE_DIMENSIONS,
+	 *   or on the stack
+	 * @param dimensions number of indexes
+	 */
+	void setArrayElement(const char*, const Parser::Value&, const uint16_t*,
+	    uint8_t);
+#endif
 	/**
 	 * @brief create array
 	 * @param name array name
@@ -461,16 +712,39 @@ public:
 	 * @param var name of the variable
 	 */
 	void valueFromVar(Parser::Value&, const char*);
+#if FAST_VARIABLE_ACCESS
+	/**
+	 * @brief Fill value object with the value of a variable, using frame
+	 *   address, resolved by the RUN command, if bindings are still valid
+	 * @param val value object
+	 * @param var name of the variable
+	 * @param address resolved frame address
+	 */
+	void valueFromVar(Parser::Value&, const char*, uint16_t);
+#endif
 	/**
 	 * @brief Fill value object with the value of an array element
 	 * @param val value object
 	 * @param var name of the array
 	 */
 	bool valueFromArray(Parser::Value&, const char*);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief Fill value object with the value of an array element with
+	 *   evaluated indexes
+	 * @param val value object
+	 * @param var name of the array
+	 * @param subscripts indexes, if not more then ARRAY_CACHE_DIMENSIONS,
+	 *   or on the stack
+	 * @param dimensions number of indexes
+	 */
+	bool valueFromArray(Parser::Value&, const char*, const uint16_t*,
+	    uint8_t);
+#endif
 	/**
 	 * @brief push string constant on the stack
 	 */
-	void pushString(const char*);
+	bool pushString(const char*);
 	/**
 	 * @brief push the next array dimesion on the stack
 	 * @param dim dimension value
@@ -510,6 +784,46 @@ public:
 	Program _program;
 
 	Parser& parser() { return _parser; }
+#if CONF_MODULE_SNAPSHOT || EXTMEMFS_IMAGE
+	/**
+	 * @brief Get checksum of the token and module command tables and
+	 *   constant sizes, which define tokenized program text format
+	 * @return checksum
+	 */
+	uint16_t textFormatChecksum();
+#if FAST_MODULE_CALL
+	/**
+	 * @brief Replace module command addresses in the program text by
+	 *   command numbers or vice versa
+	 * @param toIndex direction of replacement
+	 * @return flag of success
+	 */
+	bool relocateCommands(bool);
+	/**
+	 * @brief Replace module command addresses in one program line
+	 * @param line program line
+	 * @param toIndex direction of replacement
+	 * @return flag of success
+	 */
+	bool relocateCommands(Program::Line&, bool);
+#endif
+#endif // CONF_MODULE_SNAPSHOT || EXTMEMFS_IMAGE
+#if CONF_MODULE_SNAPSHOT
+	/**
+	 * @brief Write interpreter state: program memory, execution position
+	 *   and FSM state. Running program resumes after the current
+	 *   statement
+	 * @param out output stream
+	 * @return flag of success
+	 */
+	bool saveSnapshot(Print&);
+	/**
+	 * @brief Restore interpreter state, written by saveSnapshot()
+	 * @param in input stream
+	 * @return flag of success, program memory is cleared on bad snapshot
+	 */
+	bool loadSnapshot(Stream&);
+#endif // CONF_MODULE_SNAPSHOT
 
 #if CONF_USE_EXTMEMFS
 	void setSDFSModule(BASIC::ExtmemFSModule* newVal) { m_sdfs = newVal; }
@@ -554,12 +868,30 @@ private:
 	ArrayFrame *getSquareArray(const char*);
 #endif // USE_MATRIX
 
+	/**
+	 * @brief Execute the current statement of the running program
+	 * @param poll read the input for the break key
+	 */
+	void execStatement(bool);
 	// Get next input object from stack
 	bool nextInput();
 	// Place input values to objects
 	void doInput();
 
 	void print(Lexer&);
+	/**
+	 * @brief Fill value object with the value of the variable frame
+	 * @param val value object
+	 * @param f variable frame
+	 */
+	void valueFromFrame(Parser::Value&, const VariableFrame&);
+#if FAST_VARIABLE_ACCESS
+	/**
+	 * @brief Create all variables, referenced in program text, and write
+	 *   their frame addresses to the text
+	 */
+	void bindVariables();
+#endif
 
 	void raiseError(ErrorType, ErrorCodes = NO_ERROR, bool = true);
 	/**
@@ -577,6 +909,34 @@ private:
 	ArrayFrame *addArray(const char*, uint8_t, uint16_t);
 
 	bool arrayElementIndex(ArrayFrame*, uint16_t&);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief Array element index, computed using cached strides
+	 * @param d array descriptor
+	 * @param subscripts indexes
+	 * @param dimensions number of indexes
+	 * @param index element index
+	 * @return flag of success
+	 */
+	bool arrayElementIndex(const Program::ArrayDescriptor&,
+	    const uint16_t*, uint8_t, uint16_t&);
+#endif
+	/**
+	 * @brief Fill value object with the value of an array element
+	 * @param val value object
+	 * @param f array frame
+	 * @param index element index
+	 * @return flag of success
+	 */
+	bool valueFromElement(Parser::Value&, const ArrayFrame&, uint16_t);
+	/**
+	 * @brief set string element of the STRING array
+	 * @param f array frame
+	 * @param index element index
+	 * @param str string to copy
+	 * @return flag of success
+	 */
+	bool setArrayString(ArrayFrame&, uint16_t, const char*);
 #if USE_SAVE_LOAD
 	/**
 	 * @brief Check program text
@@ -632,6 +992,14 @@ private:
 #if CONF_USE_EXTMEMFS
 	BASIC::ExtmemFSModule*	m_sdfs;
 #endif
+#if FAST_VARIABLE_ACCESS
+	// Variables of the running program are bound after frames change
+	bool			_bindVariables;
+#endif
+#if CONF_EXEC_QUANTUM
+	// Statements per step
+	uint8_t			_execQuantum;
+#endif
 #if CONF_ERROR_STRINGS
 	static PGM_P const errorStrings[] PROGMEM;
 #endif
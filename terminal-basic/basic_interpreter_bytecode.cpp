@@ -0,0 +1,312 @@
+/*
+ * This file is part of Terminal-BASIC: a lightweight BASIC-like language
+ * interpreter.
+ * 
+ * Copyright (C) 2016-2018 Andrey V. Skvortsov <starling13@mail.ru>
+ * Copyright (C) 2019-2021 Terminal-BASIC team
+ *     <https://github.com/terminal-basic-team>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basic_interpreter.hpp"
+
+#if CONF_BYTECODE
+
+#include <string.h>
+
+namespace BASIC
+{
+
+bool
+Interpreter::runBytecode(const uint8_t *text, bool &more)
+{
+	// Skipped loop bodies and THEN lists are scanned by the parser
+	if (!_parser.executing())
+		return false;
+
+	const Program::Position &pos = _program._current;
+	Program::BytecodeEntry *e = _program.bytecodeEntry(pos);
+	// Recently executed statements are not replaced by conflicting ones
+	if (e == nullptr)
+		return false;
+	if (e->position.index != pos.index ||
+	    e->position.position != pos.position) {
+		e->position = pos;
+		e->layout = _program._variablesLayout - 1;
+	}
+	// Variable frame addresses are resolved again if frames were moved
+	if (e->layout != _program._variablesLayout) {
+		e->layout = _program._variablesLayout;
+		if (!_parser.compile(text, e->code, e->size))
+			e->size = 0;
+	}
+	// Entries of statements, which can't be compiled, are replaced first
+	e->used = e->size != 0;
+	return e->used && execBytecode(e->code, more);
+}
+
+/*
+ * Threaded code: on GCC each operation jumps to the next one through the
+ * table of label addresses, switch is the portable variant
+ */
+#if OPT == OPT_SPEED && defined(__GNUC__)
+#define BYTECODE_THREADED 1
+#define BC_OPERATION(op) case Program::op: bc_##op
+#define BC_DISPATCH goto *operations[op = *pc++]
+#else
+#define BYTECODE_THREADED 0
+#define BC_OPERATION(op) case Program::op
+#define BC_DISPATCH break
+#endif
+
+bool
+Interpreter::execBytecode(const uint8_t *pc, bool &more)
+{
+#if BYTECODE_THREADED
+	// Ordered as Program::Opcode
+	static const void *const operations[] = {
+		&&bc_BC_CONST, &&bc_BC_VAR,
+#if CONF_ARRAY_CACHE
+		&&bc_BC_ARRAY,
+#else
+		// Not emitted
+		&&bc_BC_EOL,
+#endif
+		&&bc_BC_NEG,
+		&&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary,
+		&&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary,
+		&&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary, &&bc_binary,
+		&&bc_BC_SET,
+#if CONF_ARRAY_CACHE
+		&&bc_BC_SET_ARRAY,
+#else
+		&&bc_BC_EOL,
+#endif
+		&&bc_BC_IFNOT_EOL, &&bc_BC_IFNOT_SKIP,
+#if OPT_SHORT_CIRCUIT
+		&&bc_BC_OR_SKIP, &&bc_BC_AND_SKIP,
+#else
+		// Not emitted
+		&&bc_BC_EOL, &&bc_BC_EOL,
+#endif
+		&&bc_BC_GOTO,
+		&&bc_BC_THEN, &&bc_BC_GOSUB, &&bc_BC_RETURN, &&bc_BC_NEXT,
+		&&bc_BC_COLON, &&bc_BC_EOL
+	};
+	static_assert(sizeof(operations) / sizeof(operations[0]) ==
+	    Program::BC_EOL + 1, "Bytecode operations table");
+#endif // BYTECODE_THREADED
+
+	Parser::Value stack[BYTECODE_STACK_SIZE];
+	uint8_t sp = 0;
+	uint8_t op;
+	while (true) {
+		op = *pc++;
+		switch (op) {
+		BC_OPERATION(BC_CONST):
+			memcpy(&stack[sp++], pc, sizeof(Parser::Value));
+			pc += sizeof(Parser::Value);
+			BC_DISPATCH;
+		BC_OPERATION(BC_VAR):
+			valueFromFrame(stack[sp++],
+			    *reinterpret_cast<const VariableFrame*>(
+			    _program._text + readValue<uint16_t>(pc)));
+			pc += sizeof(uint16_t);
+			BC_DISPATCH;
+		BC_OPERATION(BC_SET):
+			set(*reinterpret_cast<VariableFrame*>(_program._text +
+			    readValue<uint16_t>(pc)), stack[--sp]);
+			pc += sizeof(uint16_t);
+			BC_DISPATCH;
+#if CONF_ARRAY_CACHE
+		BC_OPERATION(BC_ARRAY): {
+			const uint8_t dimensions = *pc;
+			sp -= dimensions;
+			uint16_t index;
+			const ArrayFrame *f = bytecodeElement(
+			    reinterpret_cast<const char*>(pc + 1), stack + sp,
+			    dimensions, index);
+			// Errors are raised by the parser
+			if (f == nullptr || !valueFromElement(stack[sp++], *f,
+			    index))
+				return false;
+			pc += 1 + VARSIZE;
+			BC_DISPATCH;
+		}
+		BC_OPERATION(BC_SET_ARRAY): {
+			const uint8_t dimensions = *pc;
+			const Parser::Value &v = stack[--sp];
+			sp -= dimensions;
+			uint16_t index;
+			ArrayFrame *f = bytecodeElement(
+			    reinterpret_cast<const char*>(pc + 1), stack + sp,
+			    dimensions, index);
+			if (f == nullptr)
+				return false;
+			f->set(index, v);
+			pc += 1 + VARSIZE;
+			BC_DISPATCH;
+		}
+#endif // CONF_ARRAY_CACHE
+		BC_OPERATION(BC_NEG):
+			stack[sp-1].switchSign();
+			BC_DISPATCH;
+		BC_OPERATION(BC_IFNOT_EOL):
+			if (!bool(stack[--sp])) {
+				more = false;
+				return true;
+			}
+			BC_DISPATCH;
+		BC_OPERATION(BC_IFNOT_SKIP):
+			if (bool(stack[--sp]))
+				++pc;
+			else
+				pc += *pc + 1;
+			BC_DISPATCH;
+#if OPT_SHORT_CIRCUIT
+		BC_OPERATION(BC_OR_SKIP):
+			if (stack[sp-1].decidesOr())
+				pc += *pc + 1;
+			else
+				++pc;
+			BC_DISPATCH;
+		BC_OPERATION(BC_AND_SKIP):
+			if (stack[sp-1].decidesAnd())
+				pc += *pc + 1;
+			else
+				++pc;
+			BC_DISPATCH;
+#endif // OPT_SHORT_CIRCUIT
+		BC_OPERATION(BC_GOTO):
+		BC_OPERATION(BC_THEN):
+		BC_OPERATION(BC_GOSUB): {
+#if FAST_LINE_JUMP
+			const uint16_t address = readValue<uint16_t>(pc);
+			pc += sizeof(address);
+#endif
+			if (op == Program::BC_GOSUB) {
+				_lexer.setPointer(*pc);
+				pushReturnAddress();
+			}
+#if FAST_LINE_JUMP
+			gotoLine(stack[--sp], address);
+#else
+			gotoLine(stack[--sp]);
+#endif
+			if (op != Program::BC_THEN) {
+				more = false;
+				return true;
+			}
+			BC_DISPATCH;
+		}
+		BC_OPERATION(BC_RETURN):
+			returnFromSub();
+			more = false;
+			return true;
+		BC_OPERATION(BC_NEXT):
+			if (!next(reinterpret_cast<const char*>(pc))) {
+				more = false;
+				return true;
+			}
+			pc += VARSIZE;
+			BC_DISPATCH;
+		BC_OPERATION(BC_COLON):
+			_lexer.setPointer(*pc);
+			more = true;
+			return true;
+		BC_OPERATION(BC_EOL):
+			more = false;
+			return true;
+		default: {
+#if BYTECODE_THREADED
+bc_binary:
+#endif
+			// Binary operations
+			const Parser::Value &v2 = stack[--sp];
+			Parser::Value &v = stack[sp-1];
+			switch (op) {
+			case Program::BC_ADD:
+				v += v2;
+				break;
+			case Program::BC_SUB:
+				v -= v2;
+				break;
+			case Program::BC_MUL:
+				v *= v2;
+				break;
+			case Program::BC_DIV:
+				v /= v2;
+				break;
+#if USE_INTEGER_DIV
+			case Program::BC_IDIV:
+				v.divEquals(v2);
+				break;
+			case Program::BC_MOD:
+				v.modEquals(v2);
+				break;
+#endif
+			case Program::BC_POW:
+				v ^= v2;
+				break;
+			case Program::BC_LT:
+				v = v < v2;
+				break;
+			case Program::BC_LTE:
+				v = (v < v2) || (v == v2);
+				break;
+			case Program::BC_GT:
+				v = v > v2;
+				break;
+			case Program::BC_GTE:
+				v = (v > v2) || (v == v2);
+				break;
+			case Program::BC_EQ:
+				v = v == v2;
+				break;
+			case Program::BC_NE:
+				v = !(v == v2);
+				break;
+			case Program::BC_AND:
+				v &= v2;
+				break;
+			case Program::BC_OR:
+				v |= v2;
+				break;
+			}
+			BC_DISPATCH;
+		}
+		}
+	}
+}
+
+#if CONF_ARRAY_CACHE
+ArrayFrame*
+Interpreter::bytecodeElement(const char *name, const Parser::Value *values,
+    uint8_t dimensions, uint16_t &index)
+{
+	const Program::ArrayDescriptor *d = _program.arrayDescriptor(name);
+	uint16_t subscripts[ARRAY_CACHE_DIMENSIONS];
+	for (uint8_t dim = 0; dim < dimensions; ++dim)
+		subscripts[dim] = Integer(values[dim]);
+	if (d == nullptr ||
+	    !arrayElementIndex(*d, subscripts, dimensions, index))
+		return nullptr;
+	return _program.arrayByDescriptor(*d);
+}
+#endif // CONF_ARRAY_CACHE
+
+} // namespace BASIC
+
+#endif // CONF_BYTECODE
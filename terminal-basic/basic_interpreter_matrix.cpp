@@ -41,6 +41,13 @@ Interpreter::get2DArray(const char *name)
 		raiseError(DYNAMIC_ERROR, NO_SUCH_ARRAY);
 	else if (array->numDimensions != 2)
 		raiseError(DYNAMIC_ERROR, DIMENSIONS_MISMATCH);
+#if CONF_PACKED_STRING_ARRAYS
+	else if (array->type == Parser::Value::STRING) {
+		// Elements of the packed string arrays have no fixed size
+		raiseError(DYNAMIC_ERROR, INVALID_VALUE_TYPE);
+		return nullptr;
+	}
+#endif
 	
 	return array;
 }
@@ -240,6 +247,9 @@ Interpreter::setMatrixSize(ArrayFrame &array, uint16_t rows, uint16_t columns)
 		memmove(_program._text + newIndex, _program._text + oldIndex,
 		    _program._arraysEnd-oldIndex);
 		_program._arraysEnd += delta;
+#if CONF_ARRAY_CACHE
+		_program.invalidateArrayCache();
+#endif
 	}
 }
 
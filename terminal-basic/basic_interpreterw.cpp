@@ -307,6 +307,12 @@ _parser(_lexer, *this)
 #if CONF_USE_EXTMEMFS
 , m_sdfs(nullptr)
 #endif
+#if FAST_VARIABLE_ACCESS
+, _bindVariables(false)
+#endif
+#if CONF_EXEC_QUANTUM
+, _execQuantum(EXEC_QUANTUM)
+#endif
 {
 	_input.setTimeout(10000L);
 }
@@ -436,36 +442,78 @@ Interpreter::step()
 		_state = EXECUTE;
 		break;
 #endif // BASIC_MULTITERMINAL
-	case EXECUTE: {
-		c = char(ASCII::NUL);
-		if (_input.available() > 0) {
-			c = _input.read();
-#if USE_INKEY
-			_inputBuffer[0] = c;
-#endif // USE_GET
-		}
-		Program::Line *s = _program.current(_program._current);
-		if (s != nullptr && c != char(ASCII::EOT)) {
-			bool res;
-			if (!_parser.parse(s->text + _program._current.position,
-			    res, true))
-				_program.getNextLine();
-			else
-				_program._current.position += _lexer.getPointer();
-			if (!res)
-				raiseError(STATIC_ERROR);
-		} else
-			_state = SHELL;
-	}
+	case EXECUTE:
+#if CONF_EXEC_QUANTUM
+		for (uint8_t i = 0; i < _execQuantum && _state == EXECUTE; ++i)
+			execStatement(i % EXEC_POLL_PERIOD == 0);
+#else
+		execStatement(true);
+#endif
 	// Fall through
 	default:
 		break;
 	}
 }
 
+#if CONF_EXEC_QUANTUM
+void
+Interpreter::setExecQuantum(uint8_t statements)
+{
+	_execQuantum = statements > 0 ? statements : 1;
+}
+#endif
+
+void
+Interpreter::execStatement(bool poll)
+{
+	char c = char(ASCII::NUL);
+	if (poll && _input.available() > 0) {
+		c = _input.read();
+#if USE_INKEY
+		_inputBuffer[0] = c;
+#endif // USE_GET
+	}
+	Program::Line *s = _program.current(_program._current);
+	if (s != nullptr && c != char(ASCII::EOT)) {
+		bool res = true, more;
+#if CONF_LINE_CACHE
+		const uint8_t *text = _program.cachedLineText(
+		    _program._current.index);
+		if (text == nullptr) {
+			raiseError(DYNAMIC_ERROR, COMMAND_FAILED);
+			return;
+		}
+#else
+		const uint8_t *text = s->text;
+#endif
+#if CONF_BYTECODE
+		if (!runBytecode(text + _program._current.position,
+		    more))
+#endif
+			more = _parser.parse(text +
+			    _program._current.position, res, true);
+		if (!more) {
+			_program.getNextLine();
+#if FAST_VARIABLE_ACCESS
+			// Frames were added or moved by the last line
+			if (_bindVariables && !_program._variablesBound)
+				bindVariables();
+#endif
+		} else
+			_program._current.position += _lexer.getPointer();
+		if (!res)
+			raiseError(STATIC_ERROR);
+	} else
+		_state = SHELL;
+}
+
 void
 Interpreter::exec()
 {
+#if CONF_EVAL_STACK
+	// Values, left by the previous command, are dropped
+	_program._evalDepth = 0;
+#endif
 	_lexer.init(_inputBuffer, false);
 	if (_inputPosition == 0 && _lexer.getNext() &&
 	    (_lexer.getToken() == Token::C_INTEGER)) {
@@ -476,13 +524,23 @@ Interpreter::exec()
 			if (!_program.addLine(_parser, pLine, _inputBuffer + position)) {
 				raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
 				_state = SHELL;
-			} else
+			} else {
+#if CONF_LINE_CHECK
+				// Line is stored, its syntax error is reported
+				if (_parser.getError() != Parser::NO_ERROR)
+					raiseError(STATIC_ERROR, NO_ERROR, false);
+#endif
 				_state = PROGRAM_INPUT;
+			}
 		} else {
 			_program.removeLine(pLine);
 			_state = PROGRAM_INPUT;
 		}
 	} else {
+#if CONF_TEXT_GAP
+		// Direct mode command can read program text
+		_program.closeGap();
+#endif
 		bool res;
 		while (_parser.parse(_inputBuffer+_inputPosition, res, false)) {
 			if (!res) {
@@ -873,7 +931,27 @@ Interpreter::print(Lexer &l)
 void
 Interpreter::run()
 {
+#if FAST_LINE_JUMP
+	_program.link();
+#endif
 	_program.reset(_program._textEnd);
+#if EXTMEMFS_STREAM
+	// Text size of the external program is 0, variables are cleared here
+	if (_program.textStorage() != nullptr) {
+		_program._variablesEnd = _program._arraysEnd = _program._textEnd;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+		_program.invalidateVariableIndex();
+#endif
+#if CONF_ARRAY_CACHE
+		_program.invalidateArrayCache();
+#endif
+	}
+#endif
+#if FAST_VARIABLE_ACCESS
+	_bindVariables = true;
+	bindVariables();
+#endif
 	_state = EXECUTE;
 #if USE_INKEY
 	_inputBuffer[0] = 0;
@@ -883,6 +961,67 @@ Interpreter::run()
 #endif
 }
 
+#if FAST_VARIABLE_ACCESS
+void
+Interpreter::bindVariables()
+{
+#if EXTMEMFS_STREAM
+	// External program text is not modified
+	if (_program.textStorage() != nullptr) {
+		_bindVariables = false;
+		return;
+	}
+#endif
+	Lexer lex;
+	// 1-st pass creates all referenced variables, moving the frames,
+	// 2-nd one writes their final addresses
+	for (uint8_t pass = 0; pass < 2; ++pass) {
+		Program::Position pos = {0, 0};
+		for (Program::Line *s = _program.getNextLine(pos); s != nullptr;
+		    s = _program.getNextLine(pos)) {
+			uint8_t start = 0;
+			lex.init(s->text, true);
+			while (lex.getNext()) {
+				if (lex.getToken() == Token::KW_REM)
+					break;
+				while (s->text[start] == ' ')
+					++start;
+				// Identifier, marked by the 2-nd tokenization pass
+				uint8_t *slot = s->text + start;
+				start = lex.getPointer();
+				if (slot[0] != ASCII_DLE ||
+				    slot[1] != BASIC_TOKEN_VARIABLE)
+					continue;
+				char name[VARSIZE];
+				strncpy(name, lex.id(), VARSIZE);
+				name[VARSIZE-1] = '\0';
+				const VariableFrame *f = _program.variableByName(name);
+				if (pass > 0) {
+					const uint16_t address = f != nullptr ?
+					    _program.objectIndex(f) - _program._textEnd :
+					    BASIC_LEXER_NOT_LINKED;
+					writeValue(address, slot + 2);
+				} else if (f == nullptr) {
+					const uint8_t size = VariableFrame::size(
+					    Parser::Value::typeFromName(name));
+					// Not enough memory, variables are accessed
+					// by name
+					if (_program._arraysEnd + size >= _program._sp) {
+						_bindVariables = false;
+						return;
+					}
+					setVariable(name, Parser::Value(Integer(0)));
+				}
+			}
+		}
+	}
+#if CONF_LINE_CACHE
+	_program.invalidateLineCache();
+#endif
+	_program._variablesBound = true;
+}
+#endif // FAST_VARIABLE_ACCESS
+
 void
 Interpreter::gotoLine(const Parser::Value &l)
 {
@@ -901,6 +1040,22 @@ Interpreter::gotoLine(const Parser::Value &l)
 		raiseError(DYNAMIC_ERROR, NO_SUCH_LINE);
 }
 
+#if FAST_LINE_JUMP
+void
+Interpreter::gotoLine(const Parser::Value &l, uint16_t address)
+{
+	if (address == BASIC_LEXER_NOT_LINKED) {
+		gotoLine(l);
+		return;
+	}
+	Program::Line *s = _program.linkedLine(Integer(l), address);
+	if (s != nullptr)
+		_program.jump(_program.objectIndex(s));
+	else
+		raiseError(DYNAMIC_ERROR, NO_SUCH_LINE);
+}
+#endif // FAST_LINE_JUMP
+
 void
 Interpreter::newProgram()
 {
@@ -923,6 +1078,16 @@ Interpreter::pushReturnAddress()
 void
 Interpreter::returnFromSub()
 {
+#if CONF_GOSUB_LINK
+	const auto f = _program.unwindToSubprogram();
+	if (f != nullptr) {
+		_program.jump(READ_VALUE(f->body.gosubReturn.calleeIndex));
+		_program._current.position = f->body.gosubReturn.textPosition;
+		_program.pop();
+		return;
+	}
+	_program._sp = _program.programSize;
+#else
 	while (true) {
 		const auto f = _program.currentStackFrame();
 		if (f == nullptr)
@@ -935,6 +1100,7 @@ Interpreter::returnFromSub()
 		}
 		_program.pop();
 	}
+#endif // CONF_GOSUB_LINK
 	raiseError(DYNAMIC_ERROR, RETURN_WO_GOSUB);
 }
 
@@ -952,6 +1118,29 @@ Interpreter::pushForLoop(const char *varName, uint8_t textPosition,
 		WRITE_VALUE(fBody.finalvalue, v);
 		WRITE_VALUE(fBody.stepValue, vStep);
 		strcpy(fBody.varName, varName);
+#if CONF_FAST_FOR_NEXT
+		// Variable frame address is resolved on the first NEXT
+		const Parser::Value::Type t = Parser::Value::typeFromName(varName);
+		fBody.nativeType = Parser::Value::STRING;
+		WRITE_VALUE(fBody.varOffset, Pointer(-1));
+		WRITE_VALUE(fBody.varLayout, uint16_t(_program._variablesLayout - 1));
+		if (t == Parser::Value::INTEGER &&
+		    v.type() == Parser::Value::INTEGER &&
+		    vStep.type() == Parser::Value::INTEGER)
+			fBody.nativeType = t;
+#if USE_REALS
+		// INTEGER values of the REAL loop are converted as NEXT does
+		else if (t == Parser::Value::REAL &&
+		    (v.type() == Parser::Value::INTEGER ||
+		     v.type() == Parser::Value::REAL) &&
+		    (vStep.type() == Parser::Value::INTEGER ||
+		     vStep.type() == Parser::Value::REAL)) {
+			fBody.nativeType = t;
+			WRITE_VALUE(fBody.finalvalue, Parser::Value(Real(v)));
+			WRITE_VALUE(fBody.stepValue, Parser::Value(Real(vStep)));
+		}
+#endif // USE_REALS
+#endif // CONF_FAST_FOR_NEXT
 	} else
 		raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
 
@@ -960,6 +1149,22 @@ Interpreter::pushForLoop(const char *varName, uint8_t textPosition,
 
 bool
 Interpreter::pushValue(const Parser::Value &v)
+{
+#if CONF_EVAL_STACK
+	if (_program._evalDepth < EVAL_STACK_SIZE) {
+		_program._evalStack[_program._evalDepth++] = v;
+		return true;
+	} else {
+		raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
+		return false;
+	}
+#else
+	return pushFrameValue(v);
+#endif
+}
+
+bool
+Interpreter::pushFrameValue(const Parser::Value &v)
 {
 	const auto f = _program.push(Program::StackFrame::VALUE);
 	if (f != nullptr) {
@@ -984,6 +1189,13 @@ Interpreter::pushInputObject(const char *varName)
 bool
 Interpreter::popValue(Parser::Value &v)
 {
+#if CONF_EVAL_STACK
+	if (_program._evalDepth > 0) {
+		v = _program._evalStack[--_program._evalDepth];
+		return true;
+	} else
+		return false;
+#else
 	const auto f = _program.currentStackFrame();
 	if ((f != nullptr) && (f->_type == Program::StackFrame::VALUE)) {
 		v = READ_VALUE(f->body.value);
@@ -991,8 +1203,20 @@ Interpreter::popValue(Parser::Value &v)
 		return true;
 	} else
 		return false;
+#endif
 }
 
+#if CONF_EVAL_STACK
+bool
+Interpreter::dropValues(uint8_t depth)
+{
+	if (_program._evalDepth < depth)
+		return false;
+	_program._evalDepth = depth;
+	return true;
+}
+#endif // CONF_EVAL_STACK
+
 bool
 Interpreter::popString(const char *&str)
 {
@@ -1037,6 +1261,10 @@ void
 Interpreter::setFnVars()
 {
 	Pointer sp = _program._sp;
+#if CONF_GOSUB_LINK
+	// Parameters walk pops the return frame, restored with the stack pointer
+	const Pointer gosubSP = _program._gosubSP;
+#endif
 	Pointer paramPtr;
 	// Set old function variables
 	uint8_t numberOfParameters = 0;
@@ -1078,6 +1306,9 @@ Interpreter::setFnVars()
 		_program._sp = ret;
 	}
 	_program._sp = sp;
+#if CONF_GOSUB_LINK
+	_program._gosubSP = gosubSP;
+#endif
 }
 
 void
@@ -1140,6 +1371,12 @@ Interpreter::next(const char *varName)
 		if ((f != nullptr) &&
 		    (f->_type == Program::StackFrame::FOR_NEXT)) { // Correct frame
 			if (strcmp(f->body.forFrame.varName, varName) == 0) {
+#if CONF_FAST_FOR_NEXT
+				VariableFrame *vf = forVariable(
+				    f->body.forFrame);
+				if (vf != nullptr)
+					return nextNative(*f, *vf);
+#endif
 				Parser::Value v;
 				valueFromVar(v, varName);
 				v += READ_VALUE(f->body.forFrame.stepValue);
@@ -1176,6 +1413,137 @@ Interpreter::testFor(Program::StackFrame &f)
 	return false;
 }
 
+#if CONF_FOR_SKIP_CACHE
+bool
+Interpreter::skipForLoop(uint8_t position)
+{
+	_program._skippedFor.index = Program::FOR_NOT_CACHED;
+	// Direct mode lines are not cached
+	if (_state != EXECUTE)
+		return false;
+
+	const Program::Position loop = { _program._current.index,
+	    uint8_t(_program._current.position + position) };
+	const Program::Position *next = _program.forSkipTarget(loop);
+	if (next == nullptr) {
+		_program._skippedFor = loop;
+		return false;
+	}
+	_program.jump(next->index);
+	_program._current.position = next->position;
+	return true;
+}
+
+void
+Interpreter::endForSkip(uint8_t position)
+{
+	if (_program._skippedFor.index == Program::FOR_NOT_CACHED)
+		return;
+	if (_state == EXECUTE && position != 0) {
+		const Program::Position next = { _program._current.index,
+		    uint8_t(_program._current.position + position) };
+		_program.setForSkipTarget(_program._skippedFor, next);
+	}
+	_program._skippedFor.index = Program::FOR_NOT_CACHED;
+}
+#endif // CONF_FOR_SKIP_CACHE
+
+#if CONF_LINE_SKIP_CACHE
+bool
+Interpreter::lineSkipped(uint8_t position)
+{
+	// Direct mode lines are not cached
+	if (_state != EXECUTE)
+		return false;
+
+	const Program::Position pos = { _program._current.index,
+	    uint8_t(_program._current.position + position) };
+	return _program.lineSkipCached(pos);
+}
+
+void
+Interpreter::setLineSkip(uint8_t position)
+{
+	if (_state != EXECUTE)
+		return;
+
+	const Program::Position pos = { _program._current.index,
+	    uint8_t(_program._current.position + position) };
+	_program.setLineSkip(pos);
+}
+#endif // CONF_LINE_SKIP_CACHE
+
+#if CONF_LINE_CHECK
+bool
+Interpreter::lineChecked()
+{
+	// Direct mode lines are not checked
+	if (_state != EXECUTE)
+		return false;
+
+	const Program::Line *l = _program.current(_program._current);
+	return l != nullptr && l->checked;
+}
+#endif // CONF_LINE_CHECK
+
+#if CONF_FAST_FOR_NEXT
+VariableFrame*
+Interpreter::forVariable(Program::StackFrame::ForBody &fBody)
+{
+	if (fBody.nativeType == Parser::Value::STRING)
+		return nullptr;
+
+	// Frame address is valid while the variables are not added or moved
+	VariableFrame *f;
+	if (READ_VALUE(fBody.varLayout) == _program._variablesLayout) {
+		f = _program.variableByIndex(_program._textEnd +
+		    READ_VALUE(fBody.varOffset));
+		if (f != nullptr && strncmp(f->name, fBody.varName,
+		    VARSIZE) == 0)
+			return f;
+	}
+	f = _program.variableByName(fBody.varName);
+	if (f == nullptr || f->type != fBody.nativeType)
+		return nullptr;
+	WRITE_VALUE(fBody.varOffset, Pointer(_program.objectIndex(f) -
+	    _program._textEnd));
+	WRITE_VALUE(fBody.varLayout, _program._variablesLayout);
+	return f;
+}
+
+bool
+Interpreter::nextNative(Program::StackFrame &f, VariableFrame &v)
+{
+	auto &fBody = f.body.forFrame;
+	const Parser::Value step = READ_VALUE(fBody.stepValue);
+	const Parser::Value final = READ_VALUE(fBody.finalvalue);
+	bool over;
+#if USE_REALS
+	if (fBody.nativeType == Parser::Value::REAL) {
+		const Real s = step.m_value.body.real;
+		const Real r = v.get<Real>() + s;
+		v.set(r);
+		over = s > Real(0) ? r > final.m_value.body.real :
+		    r < final.m_value.body.real;
+	} else
+#endif
+	{
+		const Integer s = step.m_value.body.integer;
+		const Integer i = v.get<Integer>() + s;
+		v.set(i);
+		over = s > 0 ? i > final.m_value.body.integer :
+		    i < final.m_value.body.integer;
+	}
+	if (over) {
+		_program.pop();
+		return true;
+	}
+	_program.jump(READ_VALUE(fBody.calleeIndex));
+	_program._current.position = fBody.textPosition;
+	return false;
+}
+#endif // CONF_FAST_FOR_NEXT
+
 #if USE_SAVE_LOAD
 void
 Interpreter::save()
@@ -1289,6 +1657,287 @@ Interpreter::loadText(Pointer len, bool showProgress)
 }
 #endif // USE_SAVE_LOAD
 
+#if CONF_MODULE_SNAPSHOT || EXTMEMFS_IMAGE
+uint16_t
+Interpreter::textFormatChecksum()
+{
+	// Tokenized text depends on token table, line header, sizes of the
+	// constants and command numbers of the modules
+	uint8_t buf[16];
+	uint16_t crc = 0;
+	for (uint8_t t = 0; t < uint8_t(Token::INTEGER_IDENT); ++t) {
+		if (Lexer::getTokenString(Token(t), buf))
+			crc = tools_crc16_buffer(crc, buf,
+			    strlen((const char*)buf)+1);
+	}
+	const uint8_t sizes[] = {
+		uint8_t(Token::NUM_TOKENS),
+		sizeof(Pointer),
+		sizeof(Program::Line),
+		sizeof(Integer)
+#if USE_LONGINT
+		, sizeof(LongInteger)
+#endif
+#if USE_REALS
+		, sizeof(Real)
+#if USE_LONG_REALS
+		, sizeof(LongReal)
+#endif
+#endif // USE_REALS
+	};
+	crc = tools_crc16_buffer(crc, sizes, sizeof(sizes));
+#if FAST_MODULE_CALL
+	FunctionBlock::command c;
+	for (uint16_t n = 0; (c = _parser.getCommandByIndex(n)) != nullptr;
+	    ++n) {
+		_parser.getCommandName(c, buf);
+		crc = tools_crc16_buffer(crc, buf,
+		    strlen((const char*)buf)+1);
+	}
+#endif // FAST_MODULE_CALL
+	return crc;
+}
+
+#if FAST_MODULE_CALL
+bool
+Interpreter::relocateCommands(bool toIndex)
+{
+	bool result = true;
+	Program::Position pos = {0, 0};
+	for (Program::Line *s = _program.getNextLine(pos); s != nullptr;
+	    s = _program.getNextLine(pos)) {
+		if (!relocateCommands(*s, toIndex))
+			result = false;
+	}
+	return result;
+}
+
+bool
+Interpreter::relocateCommands(Program::Line &line, bool toIndex)
+{
+	bool result = true;
+	Lexer lex;
+	lex.init(line.text, true);
+	while (lex.getNext()) {
+		const Token t = lex.getToken();
+		if (t == Token::KW_REM)
+			break;
+		else if (t != Token::COMMAND)
+			continue;
+		uint8_t *p = line.text + lex.getPointer() - sizeof(uintptr_t);
+		const uintptr_t value = readValue<uintptr_t>(p);
+		if (toIndex) {
+			uint16_t index;
+			if (_parser.getCommandIndex(
+			    reinterpret_cast<FunctionBlock::command>(value),
+			    index))
+				writeValue(uintptr_t(index), p);
+			else
+				result = false;
+		} else {
+			FunctionBlock::command c = nullptr;
+			if (value < 0xFFFF)
+				c = _parser.getCommandByIndex(value);
+			if (c != nullptr)
+				writeValue(uintptr_t(c), p);
+			else
+				result = false;
+		}
+	}
+	return result;
+}
+#endif // FAST_MODULE_CALL
+#endif // CONF_MODULE_SNAPSHOT || EXTMEMFS_IMAGE
+
+#if CONF_MODULE_SNAPSHOT
+static const uint8_t snapshotMagic[] PROGMEM = { ASCII_NUL, 'T', 'S' };
+
+// Snapshot format version
+static const uint8_t snapshotVersion = 1;
+
+static bool
+writeBytes(Print &out, const void *buf, size_t len)
+{
+	const uint8_t *b = reinterpret_cast<const uint8_t*>(buf);
+	while (len-- > 0) {
+		if (out.write(*(b++)) != 1)
+			return false;
+	}
+	return true;
+}
+
+static bool
+readBytes(Stream &in, void *buf, size_t len, uint16_t &crc)
+{
+	uint8_t *b = reinterpret_cast<uint8_t*>(buf);
+	while (len-- > 0) {
+		const int c = in.read();
+		if (c < 0)
+			return false;
+		crc = tools_crc16_update(crc, c);
+		*(b++) = c;
+	}
+	return true;
+}
+
+uint16_t
+Interpreter::snapshotFormat()
+{
+	const uint16_t crc = textFormatChecksum();
+	const uint8_t sizes[] = {
+		sizeof(Program::Line),
+		sizeof(Program::StackFrame),
+		sizeof(Program::StackFrame::GosubReturn),
+		sizeof(VariableFrame),
+		VariableFrame::size(Parser::Value::STRING),
+		sizeof(ArrayFrame),
+		sizeof(Parser::Value),
+		VARSIZE,
+		CONF_USE_ALIGN,
+		CONF_PACKED_STRING_ARRAYS
+	};
+	return tools_crc16_buffer(crc, sizes, sizeof(sizes));
+}
+
+bool
+Interpreter::saveSnapshot(Print &out)
+{
+#if EXTMEMFS_STREAM
+	// Program text is not in memory
+	if (_program.textStorage() != nullptr)
+		return false;
+#endif
+#if CONF_TEXT_GAP
+	_program.closeGap();
+#endif
+	SnapshotHeader_t h;
+	memcpy_P(h.magic, snapshotMagic, sizeof(h.magic));
+	h.version = snapshotVersion;
+	h.format = snapshotFormat();
+	h.programSize = _program.programSize;
+	h.textEnd = _program._textEnd;
+	h.variablesEnd = _program._variablesEnd;
+	h.arraysEnd = _program._arraysEnd;
+	h.sp = _program._sp;
+#if CONF_GOSUB_LINK
+	h.gosubSP = _program._gosubSP;
+#endif
+	h.running = _state == EXECUTE;
+	h.current = _program._current;
+	if (h.running) {
+		// Current statement is being executed, resume after it
+		if (_lexer.getToken() == Token::COLON)
+			h.current.position += _lexer.getPointer();
+		else {
+			const Program::Line *l = _program.current(h.current);
+			if (l != nullptr)
+				h.current.index += l->size;
+			h.current.position = 0;
+		}
+	}
+#if USE_DATA
+	h.dataCurrent = _program._dataCurrent;
+	h.dataParserContinue = _dataParserContinue;
+#endif
+#if LOOP_INDENT
+	h.loopIndent = _loopIndent;
+#endif
+	h.result = _result;
+	h.crc16 = 0;
+
+#if FAST_MODULE_CALL
+	// Command addresses are valid only in the current firmware
+	if (!relocateCommands(true)) {
+		relocateCommands(false);
+		return false;
+	}
+#endif
+	// Checksum is computed before the header is written
+	uint16_t crc = tools_crc16_buffer(0, &h, sizeof(h));
+	crc = tools_crc16_buffer(crc, _program._text, h.arraysEnd);
+	crc = tools_crc16_buffer(crc, _program._text + h.sp,
+	    h.programSize - h.sp);
+	h.crc16 = crc;
+
+	const bool result = writeBytes(out, &h, sizeof(h)) &&
+	    writeBytes(out, _program._text, h.arraysEnd) &&
+	    writeBytes(out, _program._text + h.sp, h.programSize - h.sp);
+#if FAST_MODULE_CALL
+	relocateCommands(false);
+#endif
+	return result;
+}
+
+bool
+Interpreter::loadSnapshot(Stream &in)
+{
+	SnapshotHeader_t h, cur;
+	uint16_t crc = 0;
+	if (!readBytes(in, &h, sizeof(h), crc))
+		return false;
+	memcpy_P(cur.magic, snapshotMagic, sizeof(cur.magic));
+	if (memcmp(h.magic, cur.magic, sizeof(h.magic)) != 0 ||
+	    h.version != snapshotVersion || h.format != snapshotFormat() ||
+	    h.programSize != _program.programSize ||
+	    h.textEnd > h.variablesEnd || h.variablesEnd > h.arraysEnd ||
+	    h.arraysEnd > h.sp || h.sp > h.programSize
+#if CONF_GOSUB_LINK
+	    || h.gosubSP < h.sp || h.gosubSP > h.programSize
+#endif
+	    )
+		return false;
+
+	_program.newProg();
+	const uint16_t hcrc = h.crc16;
+	h.crc16 = 0;
+	crc = tools_crc16_buffer(0, &h, sizeof(h));
+	if (!readBytes(in, _program._text, h.arraysEnd, crc) ||
+	    !readBytes(in, _program._text + h.sp, h.programSize - h.sp, crc) ||
+	    crc != hcrc) {
+		_program.newProg();
+		return false;
+	}
+	_program._textEnd = h.textEnd;
+	_program._variablesEnd = h.variablesEnd;
+	_program._arraysEnd = h.arraysEnd;
+	_program._sp = h.sp;
+#if CONF_GOSUB_LINK
+	_program._gosubSP = h.gosubSP;
+#endif
+#if FAST_MODULE_CALL
+	if (!relocateCommands(false)) {
+		_program.newProg();
+		return false;
+	}
+#endif
+#if FAST_LINE_JUMP
+	_program.link();
+#endif
+#if USE_DATA
+	_program._dataCurrent = h.dataCurrent;
+	_dataParserContinue = h.dataParserContinue;
+#endif
+#if LOOP_INDENT
+	_loopIndent = h.loopIndent;
+#endif
+	_result = h.result;
+
+	_program._current = h.current;
+	if (h.running) {
+		if (_state == EXECUTE) {
+			// Position is set after the current statement
+			_program.jump(h.current.index);
+			_parser.stop();
+		}
+		_state = EXECUTE;
+	} else {
+		_parser.stop();
+		_state = SHELL;
+	}
+	return true;
+}
+#endif // CONF_MODULE_SNAPSHOT
+
 void
 Interpreter::input()
 {
@@ -1373,6 +2022,10 @@ Interpreter::doInput()
 uint8_t
 VariableFrame::size() const
 {
+#if CONF_PACKED_STRINGS
+	if (type == Parser::Value::STRING)
+		return sizeof(VariableFrame) + 1 + uint8_t(bytes[0]);
+#endif
 	return size(type);
 }
 
@@ -1398,7 +2051,11 @@ VariableFrame::size(Parser::Value::Type t)
 	case Parser::Value::LOGICAL:
 		return sizeof(VariableFrame) + sizeof (bool);
 	case Parser::Value::STRING:
+#if CONF_PACKED_STRINGS
+		return sizeof(VariableFrame) + 1 + STRING_CAPACITY_STEP;
+#else
 		return sizeof(VariableFrame) + STRING_SIZE;
+#endif
 	default:
 		return sizeof(VariableFrame);
 	}
@@ -1423,7 +2080,11 @@ VariableFrame::size(Parser::Value::Type t)
 	else if (t == Parser::Value::LOGICAL)
 		res += sizeof(bool);
 	else if (t == Parser::Value::STRING)
+#if CONF_PACKED_STRINGS
+		res += 1 + STRING_CAPACITY_STEP;
+#else
 		res += STRING_SIZE;
+#endif
 
 	return res;
 #endif // OPT
@@ -1498,10 +2159,16 @@ Interpreter::set(VariableFrame &f, const Parser::Value &v)
 	{
 		auto fr = _program.currentStackFrame();
 		if (fr == nullptr || fr->_type != Program::StackFrame::STRING) {
-			f.bytes[0] = 0;
+			f.string()[0] = 0;
+			return;
+		}
+#if CONF_PACKED_STRINGS
+		if (!reserveString(f, strlen(fr->body.string))) {
+			raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
 			return;
 		}
-		strcpy(f.bytes, fr->body.string);
+#endif
+		strcpy(f.string(), fr->body.string);
 		_program.pop();
 	}
 		break;
@@ -1510,6 +2177,38 @@ Interpreter::set(VariableFrame &f, const Parser::Value &v)
 	}
 }
 
+#if CONF_PACKED_STRINGS
+bool
+Interpreter::reserveString(VariableFrame &f, uint8_t length)
+{
+	const uint8_t capacity = f.bytes[0];
+	if (length < capacity)
+		return true;
+
+	// Frame grows by whole steps, the next frames are moved
+	const uint8_t newCapacity = (length / STRING_CAPACITY_STEP + 1) *
+	    STRING_CAPACITY_STEP;
+	const uint8_t dist = newCapacity - capacity;
+	if (_program._arraysEnd + dist >= _program._sp)
+		return false;
+	const Pointer index = _program.objectIndex(&f) + f.size();
+	memmove(_program._text + index + dist, _program._text + index,
+	    _program._arraysEnd - index);
+	_program._variablesEnd += dist;
+	_program._arraysEnd += dist;
+	f.bytes[0] = newCapacity;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	_program.invalidateVariableIndex();
+#endif
+#if CONF_USE_ALIGN
+	return _program.alignVars(_program._textEnd);
+#else
+	return true;
+#endif
+}
+#endif // CONF_PACKED_STRINGS
+
 bool
 Interpreter::readInput()
 {
@@ -1642,6 +2341,10 @@ Interpreter::newFunction(const char *fname, uint8_t pos)
 	ff->linePosition = _program._current.position+pos;
 	_program._variablesEnd += dist;
 	_program._arraysEnd += dist;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	_program.invalidateVariableIndex();
+#endif
 }
 #endif // USE_DEFFN
 
@@ -1760,6 +2463,10 @@ Interpreter::raiseError(ErrorType type, ErrorCodes errorCode, bool fatal)
 		print(long(READ_VALUE(l->number)), VT100::C_YELLOW);
 		_output.print(':');
 	}
+#if CONF_FOR_SKIP_CACHE
+	// Loop body scan is interrupted
+	endForSkip(0);
+#endif
 	if (type == DYNAMIC_ERROR)
 		print(ProgMemStrings::S_SEMANTIC);
 	else // STATIC_ERROR
@@ -1781,8 +2488,13 @@ Interpreter::raiseError(ErrorType type, ErrorCodes errorCode, bool fatal)
 	}
 	newline();
 
-	if (fatal)
+	if (fatal) {
 		_state = SHELL;
+#if CONF_EVAL_STACK
+		// Operands of the interrupted expression are dropped
+		_program._evalDepth = 0;
+#endif
+	}
 }
 
 bool
@@ -1808,12 +2520,21 @@ Interpreter::arrayElementIndex(ArrayFrame *f, uint16_t &index)
 VariableFrame*
 Interpreter::setVariable(const char *name, const Parser::Value &v)
 {
+#if CONF_VARIABLE_INDEX
+	VariableFrame *f = _program.variableByName(name);
+	if (f != nullptr) {
+		set(*f, v);
+		return f;
+	}
+#endif
 	Pointer index = _program._textEnd;
 
 #if CONF_USE_ALIGN
 	Pointer lastIndex = index;
 #endif
+#if !CONF_VARIABLE_INDEX
 	VariableFrame *f;
+#endif
 	while ((f = _program.variableByIndex(index)) != nullptr) {
 #if CONF_USE_ALIGN
 		if (_program._text[index] == 0) {
@@ -1861,8 +2582,16 @@ Interpreter::setVariable(const char *name, const Parser::Value &v)
 	    _program._arraysEnd - index);
 	_program._variablesEnd += dist;
 	_program._arraysEnd += dist;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	_program.invalidateVariableIndex();
+#endif
 	f->type = t;
 	strncpy(f->name, name, VARSIZE);
+#if CONF_PACKED_STRINGS
+	if (t == Parser::Value::STRING)
+		f->bytes[0] = STRING_CAPACITY_STEP;
+#endif
 #if CONF_USE_ALIGN
 	if (!_program.alignVars(index)) {
 		raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
@@ -1879,9 +2608,25 @@ Interpreter::setVariable(const char *name, const Parser::Value &v)
 	return f;
 }
 
+#if FAST_VARIABLE_ACCESS
+VariableFrame*
+Interpreter::setVariable(const char *name, const Parser::Value &v,
+    uint16_t address)
+{
+	VariableFrame *f = _program.boundVariable(address);
+	if (f == nullptr)
+		return setVariable(name, v);
+	set(*f, v);
+	return f;
+}
+#endif // FAST_VARIABLE_ACCESS
+
 void
 Interpreter::setArrayElement(const char *name, const Parser::Value &v)
 {
+#if CONF_PACKED_STRING_ARRAYS
+	char buf[STRING_SIZE];
+#endif
 	ArrayFrame *f = _program.arrayByName(name);
 	if (f == nullptr) {
 #if OPT_IMPLICIT_ARRAYS
@@ -1912,11 +2657,16 @@ Interpreter::setArrayElement(const char *name, const Parser::Value &v)
 			raiseError(DYNAMIC_ERROR, STRING_FRAME_SEARCH);
 			return;
 		}
+#if CONF_PACKED_STRING_ARRAYS
+		// Pool may grow over the free memory, the string is kept aside
+		strcpy(buf, fr->body.string);
+#else
 		if (_program._arraysEnd + strlen(fr->body.string) >= _program._sp) {
 			raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
 			return;
 		}
 		strcpy(_program._text+_program._arraysEnd, fr->body.string);
+#endif
 		_program.pop();
 	}
 
@@ -1927,11 +2677,61 @@ Interpreter::setArrayElement(const char *name, const Parser::Value &v)
 	}
 	f->set(index, v);
 	if (f->type == Parser::Value::STRING) {
-		strcpy((char*)(f->data()+index*STRING_SIZE),
-		    _program._text+_program._arraysEnd);
+#if CONF_PACKED_STRING_ARRAYS
+		const char *str = buf;
+#else
+		const char *str = _program._text+_program._arraysEnd;
+#endif
+		if (!setArrayString(*f, index, str))
+			raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
 	}
 }
 
+#if CONF_ARRAY_CACHE
+void
+Interpreter::setArrayElement(const char *name, const Parser::Value &v,
+    const uint16_t *subscripts, uint8_t dimensions)
+{
+	if (dimensions > ARRAY_CACHE_DIMENSIONS) {
+		setArrayElement(name, v);
+		return;
+	}
+
+	const Program::ArrayDescriptor *d = _program.arrayDescriptor(name);
+#if OPT_IMPLICIT_ARRAYS
+	if (d == nullptr && _program.arrayByName(name) == nullptr) {
+		for (uint8_t dim = 0; dim < dimensions; ++dim)
+			pushDimension(10);
+		pushDimensions(dimensions);
+		newArray(name);
+		d = _program.arrayDescriptor(name);
+	}
+#endif
+	uint16_t index;
+	if (d == nullptr ||
+	    !arrayElementIndex(*d, subscripts, dimensions, index)) {
+		raiseError(DYNAMIC_ERROR, _program.arrayByName(name) == nullptr ?
+		    NO_SUCH_ARRAY : INVALID_VALUE_TYPE);
+		return;
+	}
+
+	ArrayFrame &f = *_program.arrayByDescriptor(*d);
+	if (f.type == Parser::Value::STRING) {
+		auto fr = _program.currentStackFrame();
+		if (fr == nullptr || fr->_type != Program::StackFrame::STRING) {
+			raiseError(DYNAMIC_ERROR, STRING_FRAME_SEARCH);
+			return;
+		}
+		if (!setArrayString(f, index, fr->body.string)) {
+			raiseError(DYNAMIC_ERROR, OUTTA_MEMORY);
+			return;
+		}
+		_program.pop();
+	} else
+		f.set(index, v);
+}
+#endif // CONF_ARRAY_CACHE
+
 void
 Interpreter::newArray(const char *name)
 {
@@ -1978,15 +2778,22 @@ Interpreter::getVariable(const char *name)
 	return f;
 }
 
-void
+bool
 Interpreter::pushString(const char *str)
 {
+#if CONF_PACKED_STRINGS
+	const uint8_t len = strlen(str);
+	auto f = _program.push(Program::StackFrame::STRING,
+	    Program::StackFrame::stringSize(len));
+#else
 	auto f = _program.push(Program::StackFrame::STRING);
+#endif
 	if (f == nullptr) {
 		raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
-		return;
+		return false;
 	}
 	strcpy(f->body.string, str);
+	return true;
 }
 
 void
@@ -2059,8 +2866,25 @@ Interpreter::strConcat()
 			uint8_t l2 = strlen(str1);
 			if (l1 + l2 >= STRING_SIZE)
 				l2 = STRING_SIZE - l1 - 1;
+#if CONF_PACKED_STRINGS
+			// Result frame overlaps both operands: the right one is
+			// saved, the left one is moved to the new frame body
+			char buf[STRING_SIZE];
+			strcpy(buf, str1);
+			buf[l2] = 0;
+			_program.pop();
+			auto f = _program.push(Program::StackFrame::STRING,
+			    Program::StackFrame::stringSize(l1 + l2));
+			if (f == nullptr) {
+				raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
+				return;
+			}
+			memmove(f->body.string, ff->body.string, l1);
+			strcpy(f->body.string + l1, buf);
+#else
 			strncpy(ff->body.string + l1, str1, l2);
 			ff->body.string[l1 + l2] = 0;
+#endif
 			return;
 		}
 	}
@@ -2131,7 +2955,16 @@ ArrayFrame::dataSize() const
 		break;
 	}
 	case Parser::Value::STRING:
+#if CONF_PACKED_STRING_ARRAYS
+	{
+		// Table of offsets and the pool up to the end of the last string
+		const uint16_t last = mul - 1;
+		mul = mul * sizeof(uint16_t) + stringOffset(last) +
+		    strlen(string(last)) + 1;
+	}
+#else
 		mul *= STRING_SIZE;
+#endif
 		break;
 	default:
 		break;
@@ -2269,7 +3102,11 @@ Interpreter::addArray(const char *name, uint8_t dim, uint16_t num)
 #endif
 	if (endsWith(name, '$')) {
 		t = Parser::Value::STRING;
+#if CONF_PACKED_STRING_ARRAYS
+		num *= sizeof(uint16_t) + 1;
+#else
 		num *= STRING_SIZE;
+#endif
 	} else if (endsWith(name, '%')) {
 		t = Parser::Value::INTEGER;
 		num *= sizeof (Integer);
@@ -2309,7 +3146,17 @@ Interpreter::addArray(const char *name, uint8_t dim, uint16_t num)
 	f->numDimensions = dim;
 	strcpy(f->name, name);
 	memset(f->data(), 0, num);
+#if CONF_PACKED_STRING_ARRAYS
+	// Empty strings follow each other in the pool
+	if (t == Parser::Value::STRING) {
+		for (uint16_t i = 0; i < num / (sizeof(uint16_t) + 1); ++i)
+			f->setStringOffset(i, i);
+	}
+#endif
 	_program._arraysEnd += dist;
+#if CONF_ARRAY_CACHE
+	_program.invalidateArrayCache();
+#endif
 
 	return f;
 }
@@ -2321,38 +3168,52 @@ Interpreter::valueFromVar(Parser::Value &v, const char *varName)
 	const auto f = getVariable(varName);
 	if (f == nullptr)
 		return;
-	switch (f->type) {
+	valueFromFrame(v, *f);
+}
+
+#if FAST_VARIABLE_ACCESS
+void
+Interpreter::valueFromVar(Parser::Value &v, const char *varName,
+    uint16_t address)
+{
+	const VariableFrame *f = _program.boundVariable(address);
+	if (f == nullptr) {
+		f = getVariable(varName);
+		if (f == nullptr)
+			return;
+	}
+	valueFromFrame(v, *f);
+}
+#endif // FAST_VARIABLE_ACCESS
+
+void
+Interpreter::valueFromFrame(Parser::Value &v, const VariableFrame &f)
+{
+	switch (f.type) {
 	case Parser::Value::INTEGER:
-		v = f->get<Integer>();
+		v = f.get<Integer>();
 		break;
 #if USE_LONGINT
 	case Parser::Value::LONG_INTEGER:
-		v = f->get<LongInteger>();
+		v = f.get<LongInteger>();
 		break;
 #endif
 #if USE_REALS
 	case Parser::Value::REAL:
-		v = f->get<Real>();
+		v = f.get<Real>();
 		break;
 #if USE_LONG_REALS
 	case Parser::Value::LONG_REAL:
-		v = f->get<LongReal>();
+		v = f.get<LongReal>();
 		break;
 #endif
 #endif // USE_REALS
 	case Parser::Value::LOGICAL:
-		v = f->get<bool>();
+		v = f.get<bool>();
 		break;
 	case Parser::Value::STRING:
-	{
 		v.setType(Parser::Value::STRING);
-		auto fr = _program.push(Program::StackFrame::STRING);
-		if (fr == nullptr) {
-			raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
-			return;
-		}
-		strcpy(fr->body.string, f->bytes);
-	}
+		pushString(f.string());
 		break;
 	}
 }
@@ -2371,19 +3232,93 @@ Interpreter::valueFromArray(Parser::Value &v, const char *name)
 		raiseError(DYNAMIC_ERROR, INVALID_VALUE_TYPE);
 		return false;
 	}
+	return valueFromElement(v, *f, index);
+}
+
+#if CONF_ARRAY_CACHE
+bool
+Interpreter::valueFromArray(Parser::Value &v, const char *name,
+    const uint16_t *subscripts, uint8_t dimensions)
+{
+	if (dimensions > ARRAY_CACHE_DIMENSIONS)
+		return valueFromArray(v, name);
+
+	const Program::ArrayDescriptor *d = _program.arrayDescriptor(name);
+	uint16_t index;
+	if (d == nullptr ||
+	    !arrayElementIndex(*d, subscripts, dimensions, index)) {
+		raiseError(DYNAMIC_ERROR, _program.arrayByName(name) == nullptr ?
+		    NO_SUCH_ARRAY : INVALID_VALUE_TYPE);
+		return false;
+	}
+	return valueFromElement(v, *_program.arrayByDescriptor(*d), index);
+}
 
-	if (!f->get(index, v)) {
+bool
+Interpreter::arrayElementIndex(const Program::ArrayDescriptor &d,
+    const uint16_t *subscripts, uint8_t dimensions, uint16_t &index)
+{
+	if (dimensions != d.numDimensions)
+		return false;
+	index = 0;
+	for (uint8_t dim = 0; dim < dimensions; ++dim) {
+		if (subscripts[dim] > d.dimension[dim])
+			return false;
+		index += subscripts[dim] * d.stride[dim];
+	}
+	return true;
+}
+#endif // CONF_ARRAY_CACHE
+
+bool
+Interpreter::valueFromElement(Parser::Value &v, const ArrayFrame &f,
+    uint16_t index)
+{
+	if (!f.get(index, v)) {
 		raiseError(DYNAMIC_ERROR, INVALID_VALUE_TYPE);
 		return false;
 	}
-	if (v.type() == Parser::Value::STRING) {
-		auto fr = _program.push(Program::StackFrame::STRING);
-		if (fr == nullptr) {
-			raiseError(DYNAMIC_ERROR, STACK_FRAME_ALLOCATION);
+	if (v.type() == Parser::Value::STRING)
+		return pushString(f.string(index));
+	return true;
+}
+
+bool
+Interpreter::setArrayString(ArrayFrame &f, uint16_t index, const char *str)
+{
+#if CONF_PACKED_STRING_ARRAYS
+	char *s = f.string(index);
+	const uint8_t oldLength = strlen(s);
+	const uint8_t length = strlen(str);
+	if (length != oldLength) {
+		// Next strings of the pool and next arrays are moved, offsets
+		// of the next elements are corrected
+		const int16_t dist = int16_t(length) - int16_t(oldLength);
+		if (_program._arraysEnd + dist >= _program._sp)
 			return false;
+		const Pointer arrayEnd = _program.objectIndex(&f) + f.size() +
+		    dist;
+		const Pointer next = _program.objectIndex(s) + oldLength + 1;
+		memmove(s + length + 1, s + oldLength + 1,
+		    _program._arraysEnd - next);
+		_program._arraysEnd += dist;
+		strcpy(s, str);
+		const uint16_t num = f.numElements();
+		for (uint16_t i = index + 1; i < num; ++i)
+			f.setStringOffset(i, f.stringOffset(i) + dist);
+		if (arrayEnd < _program._arraysEnd) {
+#if CONF_USE_ALIGN
+			return _program.alignArrays(arrayEnd);
+#elif CONF_ARRAY_CACHE
+			_program.invalidateArrayCache();
+#endif
 		}
-		strcpy(fr->body.string, (char*)f->data() + (STRING_SIZE*index));
+		return true;
 	}
+	strcpy(s, str);
+#else
+	strcpy(f.string(index), str);
+#endif
 	return true;
 }
 
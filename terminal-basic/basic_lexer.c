@@ -90,6 +90,12 @@ basic_lexer_init(basic_lexer_context_t *self, const uint8_t *str, BOOLEAN tok)
 	self->string_to_parse = str;
 	self->tokenized = tok;
 	self->_error = BASIC_LEXER_ERROR_NOERROR;
+#if FAST_LINE_JUMP
+	self->line_address = BASIC_LEXER_NOT_LINKED;
+#endif
+#if FAST_VARIABLE_ACCESS
+	self->variable_address = BASIC_LEXER_NOT_LINKED;
+#endif
 }
 
 #define SYM ((uint8_t)(self->string_to_parse[self->string_pointer]))
@@ -476,7 +482,33 @@ _basic_lexer_tokenizedNext(basic_lexer_context_t *self)
 			readU16((uint16_t*)&self->value.body.integer,
 			    self->string_to_parse + self->string_pointer);
 			self->string_pointer += sizeof (integer_t);
+#if FAST_LINE_JUMP
+			self->line_address = BASIC_LEXER_NOT_LINKED;
+#endif
+			break;
+#if FAST_LINE_JUMP
+		/* Line number constant, followed by the line address */
+		case BASIC_TOKEN_C_LINENUM:
+			self->token = BASIC_TOKEN_C_INTEGER;
+			self->value.type = BASIC_VALUE_TYPE_INTEGER;
+			readU16((uint16_t*)&self->value.body.integer,
+			    self->string_to_parse + self->string_pointer);
+			self->string_pointer += sizeof (integer_t);
+			readU16(&self->line_address,
+			    self->string_to_parse + self->string_pointer);
+			self->string_pointer += sizeof (uint16_t);
+			break;
+#endif
+#if FAST_VARIABLE_ACCESS
+		/* Variable frame address, followed by the identifier */
+		case BASIC_TOKEN_VARIABLE:
+			readU16(&self->variable_address,
+			    self->string_to_parse + self->string_pointer);
+			self->string_pointer += sizeof (uint16_t);
+			_basic_lexer_pushSym(self);
+			_basic_lexer_ident(self);
 			break;
+#endif
 #if USE_LONGINT
 		case BASIC_TOKEN_C_LONG_INTEGER:
 			self->value.type = BASIC_VALUE_TYPE_LONG_INTEGER;
@@ -538,6 +570,9 @@ basic_lexer_getnextTokenized(basic_lexer_context_t *self)
 			break;
 		default:
 			if (tools_isAlpha(SYM)) {
+#if FAST_VARIABLE_ACCESS
+				self->variable_address = BASIC_LEXER_NOT_LINKED;
+#endif
 				_basic_lexer_pushSym(self);
 				_basic_lexer_ident(self);
 				return TRUE;
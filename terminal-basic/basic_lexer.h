@@ -37,6 +37,11 @@ typedef enum basic_lexer_error
 	BASIC_LEXER_ERROR_STRING_OVERFLOW = 1
 } basic_lexer_error_t;
 
+#if FAST_LINE_JUMP || FAST_VARIABLE_ACCESS
+/* Line number constant or identifier, which address is not resolved */
+#define BASIC_LEXER_NOT_LINKED 0xFFFFu
+#endif
+
 struct basic_lexer_context
 {
 	const uint8_t *string_to_parse;
@@ -53,6 +58,14 @@ struct basic_lexer_context
 	basic_value_t value;
 	/* scanner error */
 	basic_lexer_error_t _error;
+#if FAST_LINE_JUMP
+	/* resolved line address of the line number constant */
+	uint16_t line_address;
+#endif
+#if FAST_VARIABLE_ACCESS
+	/* resolved variable frame address of the identifier */
+	uint16_t variable_address;
+#endif
 	
 	BOOLEAN tokenized;
 };
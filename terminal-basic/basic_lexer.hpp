@@ -88,6 +88,27 @@ public:
 	 * @return identifier string
 	 */
 	const char *id() const { return m_context._id; }
+#if FAST_LINE_JUMP
+	/**
+	 * @brief get resolved address of the line number constant
+	 * @return line address or BASIC_LEXER_NOT_LINKED
+	 */
+	uint16_t getLineAddress() const
+	{
+		return m_context.token == BASIC_TOKEN_C_INTEGER ?
+		    m_context.line_address : BASIC_LEXER_NOT_LINKED;
+	}
+#endif
+#if FAST_VARIABLE_ACCESS
+	/**
+	 * @brief get resolved variable frame address of the identifier
+	 * @return frame address or BASIC_LEXER_NOT_LINKED
+	 */
+	uint16_t getVariableAddress() const
+	{
+		return m_context.variable_address;
+	}
+#endif
 	/**
 	 * @brief get current string position
 	 * @return string position index
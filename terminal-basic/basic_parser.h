@@ -35,7 +35,9 @@ __BEGIN_DECLS
 typedef enum
 {
 	BASIC_PARSER_SCAN = 0,
-	BASIC_PARSER_EXECUTE = 1
+	BASIC_PARSER_EXECUTE = 1,
+	/* Syntax check of the entered line without side effects */
+	BASIC_PARSER_CHECK = 2
 } basic_parser_mode_t;
 
 struct basic_parser_context {
@@ -97,8 +97,41 @@ public:
 	FunctionBlock::command getCommand(const char*);
 	
 	void getCommandName(FunctionBlock::command, uint8_t*);
+#if FAST_MODULE_CALL
+	bool getCommandIndex(FunctionBlock::command, uint16_t&);
+	
+	FunctionBlock::command getCommandByIndex(uint16_t);
+#endif
 
 	void addModule(FunctionBlock*);
+#if CONF_BYTECODE
+	/**
+	 * @brief Compile program statement to the bytecode
+	 * @param str tokenized statement text
+	 * @param code [out] buffer of BYTECODE_SIZE bytes
+	 * @param size [out] code size
+	 * @return false if statement can't be compiled
+	 */
+	bool compile(const uint8_t*, uint8_t*, uint8_t&);
+	/**
+	 * @brief Statements are executed, not scanned
+	 */
+	bool executing() const
+	{
+		return getMode() == EXECUTE;
+	}
+#endif
+#if CONF_LINE_CHECK
+	/**
+	 * @brief Check the syntax of the tokenized program line. Parser and
+	 *   lexer state is kept, error of the line is left in getError()
+	 * @param str tokenized line text
+	 * @param ok [out] no syntax errors were found
+	 * @return true if the line has no errors and no statements, which
+	 *   change the state if scanned
+	 */
+	bool check(const uint8_t*, bool&);
+#endif
 #if CONF_ERROR_STRINGS
 	static PGM_P const errorStrings[] PROGMEM;
 #endif
@@ -111,7 +144,8 @@ private:
 	enum Mode : uint8_t
 	{
 		SCAN = BASIC_PARSER_SCAN,
-		EXECUTE = BASIC_PARSER_EXECUTE
+		EXECUTE = BASIC_PARSER_EXECUTE,
+		CHECK = BASIC_PARSER_CHECK
 	};
 	
 	void setMode(Mode);
@@ -119,6 +153,21 @@ private:
 	
 	void setStopParse(bool);
 	bool getSTopParse() const;
+
+	/**
+	 * Precedence levels of the binary operators
+	 */
+	enum Precedence : uint8_t
+	{
+		PREC_NONE = 0,
+		PREC_OR,
+		PREC_AND,
+		PREC_RELATION,
+		PREC_ADD,
+		PREC_MUL,
+		PREC_POW
+	};
+	static Precedence precedence(Token);
 	
 	bool testExpression(Value&);
 	
@@ -142,28 +191,78 @@ private:
 	bool fPrintList();
 	bool fPrintItem();
 	bool fExpression(Value&);
-	bool fLogicalAdd(Value&);
-	bool fLogicalFinal(Value&);
-	bool fSimpleExpression(Value&);
-	bool fTerm(Value&);
-	bool fFactor(Value&);
+	/**
+	 * @brief binary operators expression
+	 * @param v [out] value
+	 * @param minPrecedence lowest precedence of the operators to parse
+	 */
+	bool fBinaryExpression(Value&, uint8_t);
 	bool fFinal(Value&);
 	bool fIfStatement();
 	bool fCommand();
 	void fCommandArguments(FunctionBlock::command);
 	bool fGotoStatement();
+#if FAST_LINE_JUMP
+	bool fJumpTarget(Value&, uint16_t&);
+#endif
 	bool fForConds();
 	bool fIdentifier(char*);
 	bool fVarList();
 	bool fArrayList();
 	bool fArray(uint8_t&);
 	bool fDimensions(uint8_t&);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief array element subscripts, not more then
+	 *   ARRAY_CACHE_DIMENSIONS ones are stored in the buffer, others are
+	 *   passed on the stack
+	 * @param dimensions number of subscripts
+	 * @param subscripts buffer of ARRAY_CACHE_DIMENSIONS values
+	 */
+	bool fArray(uint8_t&, uint16_t*);
+	bool fDimensions(uint8_t&, uint16_t*);
+#endif
 	bool fIdentifierExpr(char*, Value&);
 #if USE_MATRIX
 	bool fMatrixOperation();
 	bool fMatrixPrint();
 	bool fMatrixExpression(const char*);
 #endif
+#if CONF_BYTECODE
+	/*
+	 * Compilation of the statement subset to the bytecode. Methods follow
+	 * the grammar rules and return false if the rule can't be compiled.
+	 * Statements of the THEN list are compiled with top flag false
+	 */
+	bool cOperator(bool);
+	bool cEnd(bool);
+	bool cJumpEnd(bool);
+	bool cAssignment(bool);
+	bool cIfStatement(bool);
+	bool cJumpTarget(uint16_t&);
+	bool cJump(uint8_t, uint16_t);
+	bool cExpression();
+	bool cLogicalAdd();
+	bool cLogicalFinal();
+	bool cSimpleExpression();
+	bool cTerm();
+	bool cFactor();
+	bool cFinal();
+	bool cConstant();
+	bool cVariable(uint8_t, const char*);
+#if CONF_ARRAY_CACHE
+	bool cSubscripts(uint8_t&);
+	bool cArray(uint8_t, uint8_t, const char*);
+#endif
+	/**
+	 * @brief add operation code
+	 * @param op operation
+	 * @param depth evaluation stack depth change
+	 */
+	bool cOperation(uint8_t, int8_t);
+	bool cEmit(uint8_t);
+	bool cEmit(const void*, uint8_t);
+#endif // CONF_BYTECODE
 	// last static semantic error
 	ErrorCodes _error;
 	// lexical analyser object reference
@@ -175,6 +274,19 @@ private:
 	InternalFunctions _internal;
 	
 	basic_parser_context_t m_context;
+#if CONF_BYTECODE
+	// Code buffer of the statement being compiled
+	uint8_t *_code;
+	uint8_t _codeSize;
+	// Evaluation stack depth
+	uint8_t _codeDepth;
+	// Code has operations, changing the program state
+	bool _codeSideEffect;
+#endif
+#if CONF_LINE_SKIP_CACHE
+	// Scanned statements changed the state, scan result can't be cached
+	bool _scanEffect;
+#endif
 };
 
 } // namespace BASIC
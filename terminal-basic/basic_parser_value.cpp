@@ -226,6 +226,42 @@ Parser::Value::operator&=(const Value &v)
 	return *this;
 }
 
+#if OPT_SHORT_CIRCUIT
+bool
+Parser::Value::decidesOr() const
+{
+	switch (type()) {
+	case INTEGER:
+		return m_value.body.integer == -1;
+#if USE_LONGINT
+	case LONG_INTEGER:
+		return m_value.body.long_integer == -1;
+#endif
+	case LOGICAL:
+		return m_value.body.logical;
+	default:
+		return false;
+	}
+}
+
+bool
+Parser::Value::decidesAnd() const
+{
+	switch (type()) {
+	case INTEGER:
+		return m_value.body.integer == 0;
+#if USE_LONGINT
+	case LONG_INTEGER:
+		return m_value.body.long_integer == 0;
+#endif
+	case LOGICAL:
+		return !m_value.body.logical;
+	default:
+		return false;
+	}
+}
+#endif // OPT_SHORT_CIRCUIT
+
 size_t
 Parser::Value::printTo(Print& p) const
 {
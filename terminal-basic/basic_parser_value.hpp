@@ -109,6 +109,16 @@ public:
 	Value &operator^=(const Value&);
 	Value &operator|=(const Value&);
 	Value &operator&=(const Value&);
+#if OPT_SHORT_CIRCUIT
+	/**
+	 * @brief Value is the result of OR with any right operand
+	 */
+	bool decidesOr() const;
+	/**
+	 * @brief Value is the result of AND with any right operand
+	 */
+	bool decidesAnd() const;
+#endif
 	void switchSign();
 	
 	static size_t size(Type);
@@ -150,6 +150,21 @@ Parser::getCommandName(FunctionBlock::command c, uint8_t* buf)
 	_internal.getCommandName(c, buf);
 }
 
+#if FAST_MODULE_CALL
+bool
+Parser::getCommandIndex(FunctionBlock::command c, uint16_t &index)
+{
+	index = 0;
+	return _internal.getCommandIndex(c, index);
+}
+
+FunctionBlock::command
+Parser::getCommandByIndex(uint16_t index)
+{
+	return _internal.getCommandByIndex(index);
+}
+#endif // FAST_MODULE_CALL
+
 void Parser::addModule(FunctionBlock *module)
 {
 	_internal.setNext(module);
@@ -169,6 +184,13 @@ Parser::parse(const uint8_t *s, bool &ok, bool tok)
 	_lexer.init(s, tok);
 	m_context.stopParse = false;
 	_error = NO_ERROR;
+#if CONF_LINE_CHECK
+	// Skipped loop body line, checked at entry, has no NEXT statement
+	if (getMode() == SCAN && _interpreter.lineChecked()) {
+		ok = true;
+		return false;
+	}
+#endif
 	
 	if (_lexer.getNext())
 		return fOperators(ok);
@@ -178,6 +200,42 @@ Parser::parse(const uint8_t *s, bool &ok, bool tok)
 	}
 }
 
+#if CONF_LINE_CHECK
+bool
+Parser::check(const uint8_t *s, bool &ok)
+{
+	// Line can be added by the command being parsed, e.g. DLOAD
+	const Lexer lexer = _lexer;
+	const basic_parser_context_t context = m_context;
+#if CONF_LINE_SKIP_CACHE
+	const bool scanEffect = _scanEffect;
+#endif
+
+	_lexer.init(s, true);
+	m_context.stopParse = false;
+	_error = NO_ERROR;
+	setMode(CHECK);
+	ok = true;
+	if (_lexer.getNext()) {
+		while (fOperators(ok) && ok)
+			_lexer.getNext();
+	}
+	// Check was stopped by the statement with side effects
+	const bool checked = ok && !m_context.stopParse;
+	if (m_context.stopParse) {
+		ok = true;
+		_error = NO_ERROR;
+	}
+
+	_lexer = lexer;
+	m_context = context;
+#if CONF_LINE_SKIP_CACHE
+	_scanEffect = scanEffect;
+#endif
+	return checked;
+}
+#endif // CONF_LINE_CHECK
+
 /*
  * OPERATORS = OPERATOR | OPERATOR COLON OPERATORS
  */
@@ -269,6 +327,41 @@ Parser::fOperator()
 
 	const Token t = _lexer.getToken();
 	LOG(t);
+#if CONF_LINE_SKIP_CACHE || CONF_LINE_CHECK
+	// Statements, which change the state even if scanned
+	if (getMode() != EXECUTE) {
+		switch (t) {
+#if USE_DATA
+		case Token::KW_DATA:
+#endif
+#if USE_DEFFN
+		case Token::KW_DEF:
+#endif
+#if CONF_USE_ON_GOTO
+		case Token::KW_ON:
+#endif
+#if USESTOPCONT
+		case Token::KW_STOP:
+#endif
+		case Token::KW_END:
+		case Token::KW_INPUT:
+		case Token::KW_NEXT:
+#if CONF_LINE_CHECK
+			// Line is not checked further and is always scanned
+			if (getMode() == CHECK) {
+				m_context.stopParse = true;
+				return true;
+			}
+#endif
+#if CONF_LINE_SKIP_CACHE
+			_scanEffect = true;
+#endif
+			break;
+		default:
+			break;
+		}
+	}
+#endif // CONF_LINE_SKIP_CACHE || CONF_LINE_CHECK
 	switch (t) {
 	case Token::KW_DIM:
 		if (_lexer.getNext())
@@ -282,6 +375,15 @@ Parser::fOperator()
 #endif // USE_DEFFN
 #if USE_DATA
 	case Token::KW_DATA: {
+#if CONF_LINE_SKIP_CACHE
+		const uint8_t position = _lexer.getPointer();
+		const bool execute = getMode() == EXECUTE;
+		// Statement was checked to the end of the line before
+		if (execute && _interpreter.lineSkipped(position)) {
+			m_context.stopParse = true;
+			return true;
+		}
+#endif
 		if (getMode() == EXECUTE)
 			setMode(SCAN);
 		if (!_lexer.getNext())
@@ -289,8 +391,17 @@ Parser::fOperator()
 		bool res = fDataStatement();
 		if (!res)
 			_error = INVALID_DATA_EXPR;
-		if (getMode() == SCAN)
+		if (getMode() == SCAN) {
 			setMode(EXECUTE);
+#if CONF_FOR_SKIP_CACHE
+			// Skipped loop body scan ends here
+			_interpreter.endForSkip(0);
+#endif
+		}
+#if CONF_LINE_SKIP_CACHE
+		if (execute && res && _lexer.getToken() == Token::NOTOKENS)
+			_interpreter.setLineSkip(position);
+#endif
 		return res;
 	}
 #endif // USE_DATA
@@ -333,18 +444,32 @@ Parser::fOperator()
 #endif
 	case Token::KW_GOSUB: {
 		Value v;
+#if FAST_LINE_JUMP
+		uint16_t address;
+		if (!_lexer.getNext() || !fJumpTarget(v, address)) {
+#else
 		if (!_lexer.getNext() || !fExpression(v)) {
+#endif
 			_error = EXPRESSION_EXPECTED;
 			return false;
 		}
 		if (getMode() == EXECUTE) {
 			_interpreter.pushReturnAddress();
+#if FAST_LINE_JUMP
+			_interpreter.gotoLine(v, address);
+#else
 			_interpreter.gotoLine(v);
+#endif
 		}
-		m_context.stopParse = true;
+		// Check continues after the subroutine call
+		if (getMode() != CHECK)
+			m_context.stopParse = true;
 		break;
 	}
 	case Token::KW_IF: {
+#if CONF_LINE_SKIP_CACHE
+		const uint8_t position = _lexer.getPointer();
+#endif
 		Value v;
 		if (!_lexer.getNext() || !fExpression(v)) {
 			_error = EXPRESSION_EXPECTED;
@@ -352,9 +477,26 @@ Parser::fOperator()
 		}
 		bool res;
 		if (getMode() == EXECUTE) {
-			if (!bool(v))
+			const bool skip = !bool(v);
+			if (skip) {
+#if CONF_LINE_SKIP_CACHE
+				// Rest of the line was checked by the previous scan
+				if (_interpreter.lineSkipped(position)) {
+					m_context.stopParse = true;
+					return true;
+				}
+				_scanEffect = false;
+#endif
 				setMode(SCAN);
+			}
 			res = fIfStatement();
+#if CONF_LINE_SKIP_CACHE
+			// Scan without state changes reached the end of the line
+			if (skip && res && !_scanEffect &&
+			    (m_context.stopParse ||
+			    _lexer.getToken() == Token::NOTOKENS))
+				_interpreter.setLineSkip(position);
+#endif
 			setMode(EXECUTE);
 		} else
 			res = fIfStatement();
@@ -399,10 +541,18 @@ Parser::fOperator()
 		if (getMode() == EXECUTE) {
 			vName[VARSIZE-1] = '\0';
 			m_context.stopParse = !_interpreter.next(vName);
-		} else
+			if (!m_context.stopParse)
+				_lexer.getNext();
+		} else {
 			setMode(EXECUTE);
-		if (!m_context.stopParse)
 			_lexer.getNext();
+#if CONF_FOR_SKIP_CACHE
+			// Next skips of the loop continue after this statement
+			const Token t = _lexer.getToken();
+			_interpreter.endForSkip(t == Token::COLON ||
+			    t == Token::NOTOKENS ? _lexer.getPointer() : 0);
+#endif
+		}
 	}
 		break;
 #if USE_PEEK_POKE
@@ -452,6 +602,33 @@ Parser::fOperator()
 		}
 		_lexer.getNext();
 		break;
+#if OPT == OPT_SPEED
+	// Assignments and module commands are dispatched by the identifier
+	// token without the GOTO statement check
+	case Token::REAL_IDENT:
+	case Token::INTEGER_IDENT:
+	case Token::BOOL_IDENT: {
+		const FunctionBlock::command c =
+		    _internal.getCommand(_lexer.id());
+		if (c != nullptr) {
+			fCommandArguments(c);
+			break;
+		}
+	}
+	// fallthrough
+#if USE_LONGINT
+	case Token::LONGINT_IDENT:
+#endif
+#if USE_LONG_REALS
+	case Token::LONG_REAL_IDENT:
+#endif
+	case Token::STRING_IDENT: {
+		char vName[IDSIZE];
+		if (!fImplicitAssignment(vName))
+			return false;
+	}
+		break;
+#endif // OPT == OPT_SPEED
 	default:
 		if (fCommand() || fGotoStatement())
 			break;
@@ -598,7 +775,12 @@ Parser::fOnStatement(uint8_t index)
 			if (_lexer.getNext() &&
 			    _lexer.getToken() == Token::C_INTEGER) {
 				if (index == 0) {
+#if FAST_LINE_JUMP
+					_interpreter.gotoLine(_lexer.getValue(),
+					    _lexer.getLineAddress());
+#else
 					_interpreter.gotoLine(_lexer.getValue());
+#endif
 					return true;
 				} else if (index > 0 && _lexer.getNext() &&
 					_lexer.getToken() == Token::COMMA)
@@ -737,6 +919,16 @@ Parser::fDefStatement()
 bool
 Parser::fFnexec(Value &v)
 {
+#if CONF_LINE_SKIP_CACHE
+	// Arguments are pushed even if scanned
+	_scanEffect = true;
+#endif
+#if CONF_LINE_CHECK
+	if (getMode() == CHECK) {
+		setStopParse(true);
+		return true;
+	}
+#endif
 	char varName[IDSIZE];
 	if (_lexer.getNext() && fIdentifier(varName)) {
 		if (_lexer.getNext() && (_lexer.getToken() == Token::LPAREN) &&
@@ -746,7 +938,14 @@ Parser::fFnexec(Value &v)
 				if (_lexer.getToken() == Token::RPAREN)
 					break;
 				else if (fExpression(val)) {
-					_interpreter.pushValue(val);
+#if OPT_SHORT_CIRCUIT
+					// Arguments of the scanned call are not
+					// pushed
+					if (getMode() == EXECUTE)
+						_interpreter.pushFrameValue(val);
+#else
+					_interpreter.pushFrameValue(val);
+#endif
 					if (_lexer.getToken() == Token::COMMA) {
 						_lexer.getNext();
 						continue;
@@ -768,7 +967,7 @@ Parser::fFnexec(Value &v)
 					    _lexer.getToken() <= Token::BOOL_IDENT) {
 						Parser::Value v;
 						_interpreter.valueFromVar(v, _lexer.id());
-						_interpreter.pushValue(v);
+						_interpreter.pushFrameValue(v);
 						_interpreter.pushInputObject(_lexer.id());
 					} else if (_lexer.getToken() == Token::COMMA)
 						continue;
@@ -787,6 +986,15 @@ Parser::fFnexec(Value &v)
 			_interpreter.returnFromFn();
 			_lexer.getNext();
 		}
+#if OPT_SHORT_CIRCUIT
+		// Scanned call ends at the closing parenthesis, expression
+		// continues
+		else {
+			if (_lexer.getToken() == Token::RPAREN)
+				_lexer.getNext();
+			return true;
+		}
+#endif
 		setStopParse(true);
 		return true;
 	}
@@ -820,11 +1028,23 @@ Parser::fImplicitAssignment(char *varName)
 {
 	LOG_TRACE;
 
-	if (fIdentifier(varName) && _lexer.getNext()) {
+	if (!fIdentifier(varName))
+		return false;
+#if FAST_VARIABLE_ACCESS
+	const uint16_t address = _lexer.getVariableAddress();
+#endif
+	if (_lexer.getNext()) {
 		bool array;
+		uint8_t dimensions;
+#if CONF_ARRAY_CACHE
+		uint16_t subscripts[ARRAY_CACHE_DIMENSIONS];
+#endif
 		if (_lexer.getToken() == Token::LPAREN) {
-			uint8_t dimensions;
+#if CONF_ARRAY_CACHE
+			if (fArray(dimensions, subscripts))
+#else
 			if (fArray(dimensions))
+#endif
 				array = true;
 			else
 				return false;
@@ -837,11 +1057,22 @@ Parser::fImplicitAssignment(char *varName)
 				if (getMode() == EXECUTE) {
 					varName[VARSIZE-1] = '\0';
 					if (array)
+#if CONF_ARRAY_CACHE
+						_interpreter.setArrayElement(
+						    varName, v, subscripts,
+						    dimensions);
+#else
 						_interpreter.setArrayElement(
 						    varName, v);
+#endif
 					else
+#if FAST_VARIABLE_ACCESS
+						_interpreter.setVariable(
+						    varName, v, address);
+#else
 						_interpreter.setVariable(
 						    varName, v);
+#endif
 				}
 				return true;
 			} else
@@ -935,8 +1166,7 @@ Parser::fPrintItem()
 /*
  * EXPRESSION =
  *	OP_NOT EXPRESSION |
- *	LOGICAL_ADD_EXPRESSION |
- *	LOGICAL_ADD_EXPRESSION OP_OR LOGICAL_ADD_EXPRESSION
+ *	BINARY_EXPRESSION
  */
 bool
 Parser::fExpression(Value &v)
@@ -951,382 +1181,199 @@ Parser::fExpression(Value &v)
 		return true;
 	}
 	
-	if (!fLogicalAdd(v))
-		return false;
-
-	while (true) {
-		const Token t = _lexer.getToken();
-		if (t == Token::OP_OR) {
-			Value v2;
-			if (!_lexer.getNext() || !fLogicalAdd(v2))
-				return false;
-			
-			if (getMode() != Mode::EXECUTE)
-				continue;
-			v |= v2;
-		} else
-			return true;
-	}
+	return fBinaryExpression(v, PREC_OR);
 }
 
-/*
- * LOGICAL_ADD_EXPRESSION =
- *	LOGICAL_FINAL_EXPRESSION |
- *	LOGICAL_FINAL_EXPRESSION OP_AND LOGICAL_FINAL_EXPRESSION
- */
-bool
-Parser::fLogicalAdd(Value &v)
+Parser::Precedence
+Parser::precedence(Token t)
 {
-	LOG_TRACE;
-	
-	if (!fLogicalFinal(v))
-		return false;
-
-	while (true) {
-		const Token t = _lexer.getToken();
-		if (t == Token::OP_AND) {
-			Value v2;
-			if (!_lexer.getNext() || !fLogicalFinal(v2))
-				return false;
-			
-			if (getMode() != Mode::EXECUTE)
-				continue;
-			v &= v2;
-		} else
-			return true;
+	switch (t) {
+	case Token::OP_OR:
+		return PREC_OR;
+	case Token::OP_AND:
+		return PREC_AND;
+	case Token::LT:
+	case Token::LTE:
+	case Token::GT:
+	case Token::GTE:
+	case Token::EQUALS:
+	case Token::NE:
+#if CONF_USE_ALTERNATIVE_NE
+	case Token::NEA:
+#endif
+		return PREC_RELATION;
+	case Token::PLUS:
+	case Token::MINUS:
+		return PREC_ADD;
+	case Token::STAR:
+	case Token::SLASH:
+#if USE_INTEGER_DIV
+#if USE_REALS
+	case Token::BACK_SLASH:
+#if USE_DIV_KW
+	case Token::KW_DIV:
+#endif // USE_DIV_KW
+#endif // USE_REALS
+	case Token::KW_MOD:
+#endif // USE_INTEGER_DIV
+		return PREC_MUL;
+	case Token::POW:
+		return PREC_POW;
+	default:
+		return PREC_NONE;
 	}
 }
 
 /*
- * LOGICAL_FINAL_EXPRESSION =
- *	SIMPLE_EXPRESSION |
- *	SIMPLE_EXPRESSION REL SIMPLE_EXPRESSION
+ * Precedence climbing over the levels of the binary operators
+ *
+ * BINARY_EXPRESSION(p) =
+ *	OPERAND(p) |
+ *	OPERAND(p) BINARY_OPERATOR(q) BINARY_EXPRESSION(q+1), q >= p
+ * OPERAND(p) =
+ *	ADD BINARY_EXPRESSION(PREC_POW), p <= PREC_POW |
+ *	FINAL
+ * 
+ * Levels from the lowest: OP_OR, OP_AND, REL, ADD, MUL, POW. Operators of
+ * the same level are left associative, unary ADD binds weaker then POW
  */
 bool
-Parser::fLogicalFinal(Value &v)
+Parser::fBinaryExpression(Value &v, uint8_t minPrecedence)
 {
 	LOG_TRACE;
-	
-	if (!fSimpleExpression(v))
+
+	Token t = _lexer.getToken();
+	if (minPrecedence <= PREC_POW &&
+	    (t == Token::PLUS || t == Token::MINUS)) {
+		// Unary plus is ignored, unary minus switches sign
+		if (!_lexer.getNext() || !fBinaryExpression(v, PREC_POW))
+			return false;
+		if (t == Token::MINUS && getMode() == EXECUTE)
+			v.switchSign();
+	} else if (!fFinal(v))
 		return false;
 
 	while (true) {
-		const Token t = _lexer.getToken();
+		t = _lexer.getToken();
+		LOG(t);
+		const uint8_t p = precedence(t);
+		if (p < minPrecedence)
+			return true;
+
 		Value v2;
-#if OPT == OPT_SPEED
+#if OPT_SHORT_CIRCUIT
+		// Right operand is scanned, if the left one decides the result
+		const bool decided = getMode() == EXECUTE &&
+		    ((t == Token::OP_OR && v.decidesOr()) ||
+		     (t == Token::OP_AND && v.decidesAnd()));
+		if (decided)
+			setMode(SCAN);
+		const bool res = _lexer.getNext() &&
+		    fBinaryExpression(v2, p + 1);
+		if (decided)
+			setMode(EXECUTE);
+		if (!res)
+			return false;
+		if (decided || getMode() != EXECUTE)
+			continue;
+#else
+		if (!_lexer.getNext() || !fBinaryExpression(v2, p + 1))
+			return false;
+		if (getMode() != EXECUTE)
+			continue;
+#endif // OPT_SHORT_CIRCUIT
+
 		switch (t) {
+		case Token::OP_OR:
+			v |= v2;
+			break;
+		case Token::OP_AND:
+			v &= v2;
+			break;
 		case Token::LT:
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v = v < v2;
-				continue;
-			} else
-				return false;
+			v = v < v2;
+			break;
 		case Token::LTE:
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v = (v < v2) || (v == v2);
-				continue;
-			} else
-				return false;
+			v = (v < v2) || (v == v2);
+			break;
 		case Token::GT:
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v = v > v2;
-				continue;
-			} else
-				return false;
+			v = v > v2;
+			break;
 		case Token::GTE:
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v = (v > v2) || (v == v2);
-				continue;
-			} else
-				return false;
+			v = (v > v2) || (v == v2);
+			break;
 		case Token::EQUALS:
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE) {
 #if USE_STRINGOPS
-					if (v.type() == Value::STRING &&
-					   v2.type() == Value::STRING)
-						v = _interpreter.strCmp();
-					else
-#endif
-						v = v == v2;
-				}
-				continue;
-			} else
-				return false;
+			if (v.type() == Value::STRING &&
+			    v2.type() == Value::STRING)
+				v = _interpreter.strCmp();
+			else
+#endif // USE_STRINGOPS
+				v = v == v2;
+			break;
 		case Token::NE:
 #if CONF_USE_ALTERNATIVE_NE
 		case Token::NEA:
 #endif
-			if (_lexer.getNext() && fSimpleExpression(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v = !(v == v2);
-				continue;
-			} else
-				return false;
-		default:
-			return true;
-		}
-#else
-		if (t == Token::LT || t == Token::LTE || t == Token::GT
-		 || t == Token::GTE || t == Token::EQUALS || t == Token::NE
-#if CONF_USE_ALTERNATIVE_NE
-		 || t == Token::NEA
-#endif
-		    ) {
-			if (!_lexer.getNext() || !fSimpleExpression(v2))
-				return false;
-			
-			if (getMode() != Mode::EXECUTE)
-				continue;
-			
-			if (t == Token::LT)
-				v = v < v2;
-			else if (t == Token::LTE)
-				v = (v < v2) || (v == v2);
-			else if (t == Token::GT)
-				v = v > v2;
-			else if (t ==Token::GTE)
-				v = (v > v2) || (v == v2);
-			else if (t == Token::EQUALS) {
 #if USE_STRINGOPS
-				if (v.type() == Value::STRING &&
-				    v2.type() == Value::STRING)
-					v = _interpreter.strCmp();
-				else
+			if (v.type() == Value::STRING &&
+			    v2.type() == Value::STRING)
+				v = !_interpreter.strCmp();
+			else
 #endif // USE_STRINGOPS
-					v = v == v2;
-			} else if (t == Token::NE
-#if CONF_USE_ALTERNATIVE_NE
-				|| t == Token::NEA
-#endif
-			    ) {
+				v = !(v == v2);
+			break;
+		case Token::PLUS:
 #if USE_STRINGOPS
-				if (v.type() == Value::STRING &&
-				    v2.type() == Value::STRING)
-					v = !_interpreter.strCmp();
-				else
+			if (v.type() == Value::STRING &&
+			    v2.type() == Value::STRING)
+				_interpreter.strConcat();
+			else
 #endif // USE_STRINGOPS
-					v = !(v == v2);
-			}
-		} else
-			return true;
-#endif
+				v += v2;
+			break;
+		case Token::MINUS:
+			v -= v2;
+			break;
+		case Token::STAR:
+			v *= v2;
+			break;
+		case Token::SLASH:
+			v /= v2;
+			break;
+#if USE_INTEGER_DIV
+#if USE_REALS
+		case Token::BACK_SLASH:
+#if USE_DIV_KW
+		case Token::KW_DIV:
+#endif // USE_DIV_KW
+			v.divEquals(v2);
+			break;
+#endif // USE_REALS
+		case Token::KW_MOD:
+			v.modEquals(v2);
+			break;
+#endif // USE_INTEGER_DIV
+		case Token::POW:
+			v ^= v2;
+			break;
+		default:
+			break;
+		}
 	}
 }
 
-/*
- * SIMPLE_EXPRESSION =
- *	TERM |
- *	TERM ADD TERM
+/* FINAL =
+ *     C_INTEGER | C_REAL | C_STRING | VAR | VAR ARRAY |
+ *     LPAREN EXPRESSION RPAREN
  */
 bool
-Parser::fSimpleExpression(Value &v)
+Parser::fFinal(Value &v)
 {
 	LOG_TRACE;
 
-	if (!fTerm(v))
-		return false;
-
-	while (true) {
-		const Token t = _lexer.getToken();
-		LOG(t);
-		Value v2;
-#if OPT == OPT_SPEED
-		switch (t) {
-		case Token::PLUS:
-			if (_lexer.getNext() && fTerm(v2)) {
-				if (_mode == Mode::EXECUTE) {
-#if USE_STRINGOPS
-					if (v.type() == Value::STRING &&
-						v2.type() == Value::STRING)
-						_interpreter.strConcat();
-					else
-#endif // USE_STRINGOPS
-						v += v2;
-				}
-					continue;
-			} else
-				return false;
-		case Token::MINUS:
-			if (_lexer.getNext() && fTerm(v2)) {
-				if (_mode == Mode::EXECUTE)
-					v -= v2;
-				continue;
-			} else
-				return false;
-		default:
-			return true;
-		}
-#else
-		if (t == Token::PLUS || t == Token::MINUS) {
-			if (!_lexer.getNext() || !fTerm(v2))
-				return false;
-			if (getMode() != Mode::EXECUTE)
-				continue;
-			if ((t == Token::PLUS)) {
-#if USE_STRINGOPS
-				if (v.type() == Value::STRING &&
-				    v2.type() == Value::STRING)
-					_interpreter.strConcat();
-				else
-#endif // USE_STRINGOPS
-					v += v2;
-			} else if (t == Token::MINUS)
-				v -= v2;
-		} else
-			return true;
-#endif // OPT == OPT_SPEED
-	}
-}
-
-/*
- * TERM =
- *     FACTOR |
- *     FACTOR MUL FACTOR
- */
-bool
-Parser::fTerm(Value &v)
-{
-	LOG_TRACE;
-
-	if (!fFactor(v))
-		return false;
-
-	while (true) {
-		const Token t = _lexer.getToken();
-		LOG(t);
-		Value v2;
-#if OPT == OPT_SPEED
-		switch (t) {
-		case Token::STAR:
-			if (_lexer.getNext() && fFactor(v2)) {
-				v *= v2;
-				continue;
-			} else
-				return false;
-		case Token::SLASH:
-			if (_lexer.getNext() && fFactor(v2)) {
-				v /= v2;
-				continue;
-			} else
-				return false;
-#if USE_INTEGER_DIV
-#if USE_REALS
-		case Token::BACK_SLASH:
-#if USE_DIV_KW
-		case Token::KW_DIV:
-#endif // USE_DIV_KW
-			if (_lexer.getNext() && fFactor(v2)) {
-				v.divEquals(v2);
-				continue;
-			} else
-				return false;
-#endif // USE_REALS
-		case Token::KW_MOD:
-			if (_lexer.getNext() && fFactor(v2)) {
-				v.modEquals(v2);
-				continue;
-			} else
-				return false;
-#endif // USE_INTEGER_DIV
-		default:
-			return true;
-		}
-#else
-		if (t == Token::STAR || t == Token::SLASH
-#if USE_INTEGER_DIV
-#if USE_REALS
-		 || t == Token::BACK_SLASH
-#if USE_DIV_KW
-		 || t == Token::KW_DIV
-#endif // USE_DIV_KW
-#endif // USE_REALS
-		 || t == Token::KW_MOD
-#endif // USE_INTEGER_DIV
-		   ) {
-			if (!_lexer.getNext() || !fFactor(v2))
-				return false;
-			
-			if (getMode() != Mode::EXECUTE)
-				continue;
-			
-			if (t == Token::STAR)
-				v *= v2;
-			else if (t == Token::SLASH)
-				v /= v2;
-#if USE_INTEGER_DIV
-#if USE_REALS
-			else if (t == Token::BACK_SLASH
-#if USE_DIV_KW
-			      || t == Token::KW_DIV
-#endif // USE_DIV_KW
-			)
-				v.divEquals(v2);
-#endif // USE_REALS
-			else if (t == Token::KW_MOD)
-				v.modEquals(v2);
-#endif // USE_INTEGER_DIV
-		} else
-			return true;
-#endif // OPT == OPT_SPEED
-	}
-}
-
-/*
- * FACTOR =
- *     ADD FACTOR |
- *     FINAL |
- *     FINAL POW FINAL
- */
-bool
-Parser::fFactor(Value &v)
-{
-	LOG_TRACE;
-	
-	const Token t = _lexer.getToken();
-	if (t == Token::PLUS) { // Unary plus, ignored
-		return _lexer.getNext() && fFactor(v);
-	} else if (t == Token::MINUS) { // Unary minus, switch sign
-		if (!_lexer.getNext() || !fFactor(v))
-			return false;
-		if (getMode() == EXECUTE)
-			v.switchSign();
-		return true;
-	}
-
-	if (!fFinal(v))
-		return false;
-
-	while (true) {
-		const Token t = _lexer.getToken();
-		LOG(t);
-		if (t == Token::POW) {
-			Value v2;
-			if (_lexer.getNext() && fFinal(v2)) {
-				if (getMode() == Mode::EXECUTE)
-					v ^= v2;
-			} else
-				return false;
-		} else
-			return true;
-	}
-}
-
-/* FINAL =
- *     C_INTEGER | C_REAL | C_STRING | VAR | VAR ARRAY |
- *     LPAREN EXPRESSION RPAREN
- */
-bool
-Parser::fFinal(Value &v)
-{
-	LOG_TRACE;
-
-	const Token t = _lexer.getToken();
-	LOG(t);
+	const Token t = _lexer.getToken();
+	LOG(t);
 
 	while (true) {
 #if OPT == OPT_SPEED
@@ -1336,13 +1383,13 @@ Parser::fFinal(Value &v)
 		case Token::MINUS:
 			if (!_lexer.getNext() || !fFinal(v))
 				return false;
-			if (_mode == EXECUTE)
+			if (getMode() == EXECUTE)
 				v.switchSign();
 			return true;
 		case Token::C_INTEGER:
 		case Token::C_REAL:
 		case Token::C_BOOLEAN:
-			if (_mode == EXECUTE)
+			if (getMode() == EXECUTE)
 				v = _lexer.getValue();
 			_lexer.getNext();
 			return true;
@@ -1352,7 +1399,7 @@ Parser::fFinal(Value &v)
 				_lexer.getNext();
 				return false;
 			}
-			if (_mode == EXECUTE) {
+			if (getMode() == EXECUTE) {
 				_interpreter.pushString(_lexer.id());
 				v.setType(Value::Type::STRING);
 			}
@@ -1427,10 +1474,24 @@ Parser::fIfStatement()
 		if (_lexer.getNext()) {
 			if (_lexer.getToken() == Token::C_INTEGER) {
 				if (getMode() == EXECUTE)
+#if FAST_LINE_JUMP
+					_interpreter.gotoLine(_lexer.getValue(),
+					    _lexer.getLineAddress());
+#else
 					_interpreter.gotoLine(_lexer.getValue());
+#endif
 				_lexer.getNext();
 				return true;
 			} else {
+#if CONF_LINE_CHECK
+				// THEN list of the line, checked at entry, is
+				// skipped without the scan
+				if (getMode() == SCAN &&
+				    _interpreter.lineChecked()) {
+					m_context.stopParse = true;
+					return true;
+				}
+#endif
 				bool res;
 				while (fOperators(res)) {
 					if (!res)
@@ -1466,17 +1527,48 @@ Parser::fGotoStatement()
 #endif
 	    ) {
 		Value v;
+#if FAST_LINE_JUMP
+		uint16_t address;
+		if (!_lexer.getNext() || !fJumpTarget(v, address)) {
+#else
 		if (!_lexer.getNext() || !fExpression(v)) {
+#endif
 			_error = EXPRESSION_EXPECTED;
 			return false;
 		}
-		if (getMode() == EXECUTE)
+		if (getMode() == EXECUTE) {
+#if FAST_LINE_JUMP
+			_interpreter.gotoLine(v, address);
+#else
 			_interpreter.gotoLine(v);
+#endif
+			// Rest of the line must not be executed
+			m_context.stopParse = true;
+		}
 		return true;
 	} else
 		return false;
 }
 
+#if FAST_LINE_JUMP
+/*
+ * JUMP_TARGET = LINE_NUMBER | EXPRESSION
+ */
+bool
+Parser::fJumpTarget(Value &v, uint16_t &address)
+{
+	// Line number constant, resolved by the link pass, is the whole
+	// operand, no need to evaluate expression
+	address = _lexer.getLineAddress();
+	if (address != BASIC_LEXER_NOT_LINKED) {
+		v = _lexer.getValue();
+		_lexer.getNext();
+		return true;
+	}
+	return fExpression(v);
+}
+#endif // FAST_LINE_JUMP
+
 bool
 Parser::fCommand()
 {
@@ -1614,6 +1706,9 @@ Parser::fCommand()
 void
 Parser::fCommandArguments(FunctionBlock::command c)
 {
+#if CONF_EVAL_STACK
+	const uint8_t depth = _interpreter.valuesDepth();
+#endif
 	while (_lexer.getNext()) {
 		Value v;
 		if (fExpression(v)) {
@@ -1629,8 +1724,13 @@ Parser::fCommandArguments(FunctionBlock::command c)
 		else
 			break;
 	}
-	if (getMode() == EXECUTE)
+	if (getMode() == EXECUTE) {
 		_interpreter.execCommand(c);
+#if CONF_EVAL_STACK
+		// Arguments, not taken by the command, are dropped
+		_interpreter.dropValues(depth);
+#endif
+	}
 }
 
 /*
@@ -1674,10 +1774,14 @@ Parser::fForConds()
 		    _lexer.getPointer(), vFinal, vStep);
 		_interpreter.setVariable(vName, v);
 		if (f != nullptr) {
-			if (_interpreter.testFor(*f))
-				setMode(SCAN);
-			else
+			if (!_interpreter.testFor(*f))
 				m_context.stopParse = true;
+#if CONF_FOR_SKIP_CACHE
+			else if (_interpreter.skipForLoop(_lexer.getPointer()))
+				m_context.stopParse = true;
+#endif
+			else
+				setMode(SCAN);
 		}
 	}
 	return true;
@@ -1767,9 +1871,53 @@ Parser::fDimensions(uint8_t &dimensions)
 	return true;
 }
 
+#if CONF_ARRAY_CACHE
+bool
+Parser::fArray(uint8_t &dimensions, uint16_t *subscripts)
+{
+	if (_lexer.getToken() != Token::LPAREN ||
+	    !fDimensions(dimensions, subscripts) ||
+	    _lexer.getToken() != Token::RPAREN)
+		return false;
+
+	_lexer.getNext();
+	return true;
+}
+
+bool
+Parser::fDimensions(uint8_t &dimensions, uint16_t *subscripts)
+{
+	Parser::Value v;
+	dimensions = 0;
+	do {
+		if (!_lexer.getNext() || !fExpression(v))
+			return false;
+		if (getMode() == Mode::EXECUTE) {
+			if (dimensions < ARRAY_CACHE_DIMENSIONS)
+				subscripts[dimensions] = Integer(v);
+			else {
+				// Too many subscripts, all are passed on the
+				// stack
+				if (dimensions == ARRAY_CACHE_DIMENSIONS) {
+					for (uint8_t d = 0; d < dimensions; ++d)
+						_interpreter.pushDimension(
+						    subscripts[d]);
+				}
+				_interpreter.pushDimension(Integer(v));
+			}
+		}
+		++dimensions;
+	} while (_lexer.getToken() == Token::COMMA);
+	return true;
+}
+#endif // CONF_ARRAY_CACHE
+
 bool
 Parser::fIdentifierExpr(char *varName, Value &v)
 {
+#if FAST_VARIABLE_ACCESS
+	const uint16_t address = _lexer.getVariableAddress();
+#endif
 	// Identifier, var or func or array ?
 	if (_lexer.getNext() && _lexer.getToken()==
 	    Token::LPAREN) { // ( - array or function
@@ -1777,6 +1925,9 @@ Parser::fIdentifierExpr(char *varName, Value &v)
 		if ((f=_internal.getFunction(varName)) != nullptr) {
 			// function
 			Value arg;
+#if CONF_EVAL_STACK
+			const uint8_t depth = _interpreter.valuesDepth();
+#endif
 			do {
 				if (!_lexer.getNext())
 					return false;
@@ -1799,22 +1950,42 @@ Parser::fIdentifierExpr(char *varName, Value &v)
 				result = ((*f)(_interpreter));
 				if (!result || !_interpreter.popValue(v))
 					return false;
+#if CONF_EVAL_STACK
+				// Arguments, not taken by the function, are
+				// dropped
+				if (!_interpreter.dropValues(depth))
+					return false;
+#endif
 			}
 		} else { // No such function, array variable
 			uint8_t dim;
+#if CONF_ARRAY_CACHE
+			uint16_t subscripts[ARRAY_CACHE_DIMENSIONS];
+			if (fArray(dim, subscripts)) {
+				if (getMode() == EXECUTE) {
+					varName[VARSIZE-1] = '\0';
+					return _interpreter.valueFromArray(v,
+					    varName, subscripts, dim);
+				}
+#else
 			if (fArray(dim)) {
 				if (getMode() == EXECUTE) {
 					varName[VARSIZE-1] = '\0';
 					return _interpreter.valueFromArray(v,
 					    varName);
 				}
+#endif
 			} else
 				return false;
 		}
 	} else // variable
 		if (getMode() == EXECUTE) {
 			varName[VARSIZE-1] = '\0';
+#if FAST_VARIABLE_ACCESS
+			_interpreter.valueFromVar(v, varName, address);
+#else
 			_interpreter.valueFromVar(v, varName);
+#endif
 		}
 	
 	return true;
@@ -1973,4 +2144,533 @@ l_ok:
 
 #endif // USE_MATRIX
 
+#if CONF_BYTECODE
+bool
+Parser::compile(const uint8_t *s, uint8_t *code, uint8_t &size)
+{
+	_lexer.init(s, true);
+	_code = code;
+	_codeSize = _codeDepth = 0;
+	_codeSideEffect = false;
+	// Empty statement, e.g. the end of the line after FOR, ends the line
+	if (_lexer.getNext() ? !cOperator(true) :
+	    !cOperation(Program::BC_EOL, 0))
+		return false;
+	size = _codeSize;
+	return true;
+}
+
+/*
+ * Compiled OPERATOR subset:
+ *	KW_GOSUB JUMP_TARGET |
+ *	KW_IF EXPRESSION IF_STATEMENT |
+ *	KW_LET IMPLICIT_ASSIGNMENT |
+ *	KW_NEXT IDENT |
+ *	KW_REM TEXT |
+ *	KW_RETURN |
+ *	KW_GOTO JUMP_TARGET |
+ *	IMPLICIT_ASSIGNMENT
+ */
+bool
+Parser::cOperator(bool top)
+{
+	switch (_lexer.getToken()) {
+	case Token::KW_GOSUB: {
+		uint16_t address;
+		if (!_lexer.getNext() || !cJumpTarget(address))
+			return false;
+		// Return position follows the line address
+		return cJump(Program::BC_GOSUB, address) &&
+		    cEmit(_lexer.getPointer());
+	}
+	case Token::KW_IF:
+		return _lexer.getNext() && cExpression() && cIfStatement(top);
+	case Token::KW_LET:
+		return _lexer.getNext() && cAssignment(top);
+	case Token::KW_NEXT: {
+		// Scan of the false THEN list is resumed by NEXT, the parser
+		// executes it there
+		char vName[IDSIZE];
+		if (!top || !_lexer.getNext() || !fIdentifier(vName))
+			return false;
+		vName[VARSIZE-1] = '\0';
+		_codeSideEffect = true;
+		if (!cOperation(Program::BC_NEXT, 0) || !cEmit(vName, VARSIZE))
+			return false;
+		_lexer.getNext();
+		return cEnd(top);
+	}
+	case Token::KW_REM:
+		return cOperation(Program::BC_EOL, 0);
+	case Token::KW_RETURN:
+		_codeSideEffect = true;
+		_lexer.getNext();
+		return cOperation(Program::BC_RETURN, 0) && cJumpEnd(top);
+	case Token::KW_GOTO: {
+		uint16_t address;
+		return _lexer.getNext() && cJumpTarget(address) &&
+		    cJump(Program::BC_GOTO, address) && cJumpEnd(top);
+	}
+	default:
+		return cAssignment(top);
+	}
+}
+
+/*
+ * Statement end: COLON OPERATOR | end of line
+ */
+bool
+Parser::cEnd(bool top)
+{
+	const Token t = _lexer.getToken();
+	if (t == Token::COLON) {
+		// Top level statement is followed by the next step
+		if (top)
+			return cOperation(Program::BC_COLON, 0) &&
+			    cEmit(_lexer.getPointer());
+		return _lexer.getNext() && cOperator(false);
+	} else if (t == Token::NOTOKENS)
+		return cOperation(Program::BC_EOL, 0);
+	return false;
+}
+
+/*
+ * Jump ends the line, but the rest of THEN list is checked by the scan if
+ * condition is false. No code is added for it
+ */
+bool
+Parser::cJumpEnd(bool top)
+{
+	if (top)
+		return true;
+	const uint8_t size = _codeSize;
+	const bool res = cEnd(false);
+	_codeSize = size;
+	return res;
+}
+
+/*
+ * IMPLICIT_ASSIGNMENT = VAR EQUALS EXPRESSION | VAR ARRAY EQUALS EXPRESSION
+ */
+bool
+Parser::cAssignment(bool top)
+{
+	char vName[IDSIZE];
+	if (!fIdentifier(vName) || _internal.getCommand(vName) != nullptr ||
+	    !_lexer.getNext())
+		return false;
+	vName[VARSIZE-1] = '\0';
+#if CONF_ARRAY_CACHE
+	uint8_t dimensions;
+	const bool array = _lexer.getToken() == Token::LPAREN;
+	if (array && !cSubscripts(dimensions))
+		return false;
+#else
+	if (_lexer.getToken() == Token::LPAREN)
+		return false;
+#endif
+	if (_lexer.getToken() != Token::EQUALS || !_lexer.getNext() ||
+	    !cExpression())
+		return false;
+#if CONF_ARRAY_CACHE
+	if (array)
+		return cArray(Program::BC_SET_ARRAY, dimensions, vName) &&
+		    cEnd(top);
+#endif
+	return cVariable(Program::BC_SET, vName) && cEnd(top);
+}
+
+/*
+ * IF_STATEMENT = GOTO_STATEMENT | KW_THEN C_INTEGER | KW_THEN OPERATORS
+ */
+bool
+Parser::cIfStatement(bool top)
+{
+	const Token t = _lexer.getToken();
+	if (t == Token::KW_THEN) {
+		if (!_lexer.getNext())
+			return false;
+		// False condition skips the rest of the line
+		if (_lexer.getToken() != Token::C_INTEGER)
+			return cOperation(Program::BC_IFNOT_EOL, -1) &&
+			    cOperator(false);
+	} else if (t != Token::KW_GOTO)
+		return false;
+
+	// Line number or GOTO is skipped, if condition is false
+	if (!cOperation(Program::BC_IFNOT_SKIP, -1) || !cEmit(0))
+		return false;
+	const uint8_t skip = _codeSize;
+	if (t == Token::KW_THEN) {
+#if FAST_LINE_JUMP
+		const uint16_t address = _lexer.getLineAddress();
+#else
+		const uint16_t address = 0;
+#endif
+		if (!cConstant() || !cJump(Program::BC_THEN, address))
+			return false;
+		_lexer.getNext();
+	} else {
+		uint16_t address;
+		if (!_lexer.getNext() || !cJumpTarget(address) ||
+		    !cJump(Program::BC_GOTO, address))
+			return false;
+	}
+	_code[skip-1] = _codeSize - skip;
+	return cEnd(top);
+}
+
+/*
+ * JUMP_TARGET = LINE_NUMBER | EXPRESSION
+ */
+bool
+Parser::cJumpTarget(uint16_t &address)
+{
+#if FAST_LINE_JUMP
+	address = _lexer.getLineAddress();
+	if (address != BASIC_LEXER_NOT_LINKED) {
+		if (!cConstant())
+			return false;
+		_lexer.getNext();
+		return true;
+	}
+#else
+	address = 0;
+#endif
+	return cExpression();
+}
+
+bool
+Parser::cJump(uint8_t op, uint16_t address)
+{
+	_codeSideEffect = true;
+	if (!cOperation(op, -1))
+		return false;
+#if FAST_LINE_JUMP
+	uint8_t buf[sizeof(address)];
+	writeValue(address, buf);
+	return cEmit(buf, sizeof(buf));
+#else
+	return true;
+#endif
+}
+
+/*
+ * EXPRESSION =
+ *	OP_NOT EXPRESSION |
+ *	LOGICAL_ADD_EXPRESSION |
+ *	LOGICAL_ADD_EXPRESSION OP_OR LOGICAL_ADD_EXPRESSION
+ */
+bool
+Parser::cExpression()
+{
+	if (_lexer.getToken() == Token::OP_NOT)
+		return _lexer.getNext() && cExpression() &&
+		    cOperation(Program::BC_NEG, 0);
+
+	if (!cLogicalAdd())
+		return false;
+	while (_lexer.getToken() == Token::OP_OR) {
+#if OPT_SHORT_CIRCUIT
+		if (!cOperation(Program::BC_OR_SKIP, 0) || !cEmit(0))
+			return false;
+		const uint8_t skip = _codeSize;
+#endif
+		if (!_lexer.getNext() || !cLogicalAdd() ||
+		    !cOperation(Program::BC_OR, -1))
+			return false;
+#if OPT_SHORT_CIRCUIT
+		_code[skip-1] = _codeSize - skip;
+#endif
+	}
+	return true;
+}
+
+/*
+ * LOGICAL_ADD_EXPRESSION =
+ *	LOGICAL_FINAL_EXPRESSION |
+ *	LOGICAL_FINAL_EXPRESSION OP_AND LOGICAL_FINAL_EXPRESSION
+ */
+bool
+Parser::cLogicalAdd()
+{
+	if (!cLogicalFinal())
+		return false;
+	while (_lexer.getToken() == Token::OP_AND) {
+#if OPT_SHORT_CIRCUIT
+		if (!cOperation(Program::BC_AND_SKIP, 0) || !cEmit(0))
+			return false;
+		const uint8_t skip = _codeSize;
+#endif
+		if (!_lexer.getNext() || !cLogicalFinal() ||
+		    !cOperation(Program::BC_AND, -1))
+			return false;
+#if OPT_SHORT_CIRCUIT
+		_code[skip-1] = _codeSize - skip;
+#endif
+	}
+	return true;
+}
+
+/*
+ * LOGICAL_FINAL_EXPRESSION =
+ *	SIMPLE_EXPRESSION |
+ *	SIMPLE_EXPRESSION REL SIMPLE_EXPRESSION
+ */
+bool
+Parser::cLogicalFinal()
+{
+	if (!cSimpleExpression())
+		return false;
+	while (true) {
+		Program::Opcode op;
+		switch (_lexer.getToken()) {
+		case Token::LT:
+			op = Program::BC_LT;
+			break;
+		case Token::LTE:
+			op = Program::BC_LTE;
+			break;
+		case Token::GT:
+			op = Program::BC_GT;
+			break;
+		case Token::GTE:
+			op = Program::BC_GTE;
+			break;
+		case Token::EQUALS:
+			op = Program::BC_EQ;
+			break;
+		case Token::NE:
+#if CONF_USE_ALTERNATIVE_NE
+		case Token::NEA:
+#endif
+			op = Program::BC_NE;
+			break;
+		default:
+			return true;
+		}
+		if (!_lexer.getNext() || !cSimpleExpression() ||
+		    !cOperation(op, -1))
+			return false;
+	}
+}
+
+/*
+ * SIMPLE_EXPRESSION =
+ *	TERM |
+ *	TERM ADD TERM
+ */
+bool
+Parser::cSimpleExpression()
+{
+	if (!cTerm())
+		return false;
+	while (true) {
+		Program::Opcode op;
+		switch (_lexer.getToken()) {
+		case Token::PLUS:
+			op = Program::BC_ADD;
+			break;
+		case Token::MINUS:
+			op = Program::BC_SUB;
+			break;
+		default:
+			return true;
+		}
+		if (!_lexer.getNext() || !cTerm() || !cOperation(op, -1))
+			return false;
+	}
+}
+
+/*
+ * TERM =
+ *     FACTOR |
+ *     FACTOR MUL FACTOR
+ */
+bool
+Parser::cTerm()
+{
+	if (!cFactor())
+		return false;
+	while (true) {
+		Program::Opcode op;
+		switch (_lexer.getToken()) {
+		case Token::STAR:
+			op = Program::BC_MUL;
+			break;
+		case Token::SLASH:
+			op = Program::BC_DIV;
+			break;
+#if USE_INTEGER_DIV
+#if USE_REALS
+		case Token::BACK_SLASH:
+#if USE_DIV_KW
+		case Token::KW_DIV:
+#endif // USE_DIV_KW
+			op = Program::BC_IDIV;
+			break;
+#endif // USE_REALS
+		case Token::KW_MOD:
+			op = Program::BC_MOD;
+			break;
+#endif // USE_INTEGER_DIV
+		default:
+			return true;
+		}
+		if (!_lexer.getNext() || !cFactor() || !cOperation(op, -1))
+			return false;
+	}
+}
+
+/*
+ * FACTOR =
+ *     ADD FACTOR |
+ *     FINAL |
+ *     FINAL POW FINAL
+ */
+bool
+Parser::cFactor()
+{
+	const Token t = _lexer.getToken();
+	if (t == Token::PLUS)
+		return _lexer.getNext() && cFactor();
+	else if (t == Token::MINUS)
+		return _lexer.getNext() && cFactor() &&
+		    cOperation(Program::BC_NEG, 0);
+
+	if (!cFinal())
+		return false;
+	while (_lexer.getToken() == Token::POW) {
+		if (!_lexer.getNext() || !cFinal() ||
+		    !cOperation(Program::BC_POW, -1))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Compiled FINAL subset:
+ *     C_INTEGER | C_REAL | C_BOOLEAN | VAR | VAR ARRAY |
+ *     LPAREN EXPRESSION RPAREN
+ */
+bool
+Parser::cFinal()
+{
+	const Token t = _lexer.getToken();
+	if ((t >= Token::C_INTEGER) && (t <= Token::C_BOOLEAN)) {
+		if (!cConstant())
+			return false;
+		_lexer.getNext();
+		return true;
+	} else if (t == Token::LPAREN) {
+		if (!_lexer.getNext() || !cExpression() ||
+		    _lexer.getToken() != Token::RPAREN)
+			return false;
+		_lexer.getNext();
+		return true;
+	}
+
+	char vName[IDSIZE];
+	if (!fIdentifier(vName))
+		return false;
+	if (!_lexer.getNext() || _lexer.getToken() != Token::LPAREN) {
+		vName[VARSIZE-1] = '\0';
+		return cVariable(Program::BC_VAR, vName);
+	}
+#if CONF_ARRAY_CACHE
+	uint8_t dimensions;
+	if (_internal.getFunction(vName) != nullptr ||
+	    !cSubscripts(dimensions))
+		return false;
+	vName[VARSIZE-1] = '\0';
+	return cArray(Program::BC_ARRAY, dimensions, vName);
+#else
+	return false;
+#endif
+}
+
+bool
+Parser::cConstant()
+{
+	return cOperation(Program::BC_CONST, 1) &&
+	    cEmit(&_lexer.getValue(), sizeof(Value));
+}
+
+bool
+Parser::cVariable(uint8_t op, const char *name)
+{
+	// Frame must exist, its address is valid while variables layout is
+	// not changed
+	const VariableFrame *f = _interpreter._program.variableByName(name);
+	if (f == nullptr || f->type != Value::typeFromName(name) ||
+	    f->type == Value::STRING)
+		return false;
+	if (op == Program::BC_SET)
+		_codeSideEffect = true;
+	uint8_t buf[sizeof(uint16_t)];
+	writeValue(uint16_t(_interpreter._program.objectIndex(f)), buf);
+	return cOperation(op, op == Program::BC_VAR ? 1 : -1) &&
+	    cEmit(buf, sizeof(buf));
+}
+
+#if CONF_ARRAY_CACHE
+/*
+ * ARRAY = LPAREN DIMENSIONS RPAREN
+ */
+bool
+Parser::cSubscripts(uint8_t &dimensions)
+{
+	dimensions = 0;
+	do {
+		if (!_lexer.getNext() || !cExpression())
+			return false;
+		++dimensions;
+	} while (_lexer.getToken() == Token::COMMA);
+	if (_lexer.getToken() != Token::RPAREN)
+		return false;
+	_lexer.getNext();
+	return true;
+}
+
+bool
+Parser::cArray(uint8_t op, uint8_t dimensions, const char *name)
+{
+	// Invalid element access is repeated by the parser, so there must be
+	// no state changes before it
+	if (_codeSideEffect || dimensions > ARRAY_CACHE_DIMENSIONS ||
+	    Value::typeFromName(name) == Value::STRING)
+		return false;
+	const int8_t depth = op == Program::BC_ARRAY ? 1 - dimensions :
+	    -1 - dimensions;
+	if (op == Program::BC_SET_ARRAY)
+		_codeSideEffect = true;
+	return cOperation(op, depth) && cEmit(dimensions) &&
+	    cEmit(name, VARSIZE);
+}
+#endif // CONF_ARRAY_CACHE
+
+bool
+Parser::cOperation(uint8_t op, int8_t depth)
+{
+	_codeDepth += depth;
+	return _codeDepth <= BYTECODE_STACK_SIZE && cEmit(op);
+}
+
+bool
+Parser::cEmit(uint8_t byte)
+{
+	return cEmit(&byte, sizeof(byte));
+}
+
+bool
+Parser::cEmit(const void *data, uint8_t size)
+{
+	if (_codeSize + size > BYTECODE_SIZE)
+		return false;
+	memcpy(_code + _codeSize, data, size);
+	_codeSize += size;
+	return true;
+}
+#endif // CONF_BYTECODE
+
 } // namespace BASIC
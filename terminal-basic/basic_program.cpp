@@ -37,6 +37,15 @@ Program::Program(Pointer progsize) :
 _text(reinterpret_cast<char*> (EXTMEM_ADDRESS)),
 #endif
 programSize(progsize)
+#if CONF_EVAL_STACK
+, _evalDepth(0)
+#endif
+#if CONF_FAST_FOR_NEXT || CONF_BYTECODE
+, _variablesLayout(0)
+#endif
+#if EXTMEMFS_STREAM
+, _storage(nullptr)
+#endif
 {
 	assert(_text != nullptr);
 	assert(progsize <= SINGLE_PROGSIZE);
@@ -68,7 +77,7 @@ Program::getNextLine(Position &pos)
 Program::Line*
 Program::current(const Position &pos) const
 {
-	if (pos.index < _textEnd)
+	if (pos.index < linesEnd())
 		return lineByIndex(pos.index);
 	else
 		return nullptr;
@@ -96,6 +105,10 @@ Program::jump(Pointer newVal)
 Program::Line*
 Program::lineByIndex(Pointer address) const
 {
+#if EXTMEMFS_STREAM
+	if (_storage != nullptr)
+		return const_cast<Program*>(this)->cachedLine(address);
+#endif
 	return const_cast<Line*> (reinterpret_cast<const Line*> (
 	    _text + address));
 }
@@ -107,19 +120,185 @@ Program::lineByNumber(
 {
 	Program::Line *result = nullptr;
 
-	if (address <= _textEnd) {
+	if (address <= linesEnd()) {
+#if CONF_LINE_INDEX
+		// Start from the nearest indexed line
+		const Pointer from = lineIndexLookup(number);
+		if (from > address)
+			address = from;
+#endif
 		_current.index = address;
 		for (Line *cur = getNextLine(); cur != nullptr;
 		    cur = getNextLine()) {
-			if (READ_VALUE(cur->number) == number) {
+			const uint16_t curNumber = READ_VALUE(cur->number);
+			if (curNumber == number) {
 				result = cur;
 				break;
+			} else if (curNumber > number) { // Lines are sorted
+				// Missing line leaves the position at the end of
+				// the lines, as the full scan does
+				_current.index = linesEnd();
+				_current.position = 0;
+				break;
 			}
 		}
 	}
 	return result;
 }
 
+#if FAST_LINE_JUMP
+void
+Program::link()
+{
+	if (_linked)
+		return;
+#if EXTMEMFS_STREAM
+	// Line addresses in the external text are searched on each jump
+	if (_storage != nullptr)
+		return;
+#endif
+#if CONF_TEXT_GAP
+	closeGap();
+#endif
+
+	Lexer lexer;
+	for (Pointer index = 0; index < _textEnd;) {
+		Line *line = lineByIndex(index);
+		uint8_t start = 0;
+		lexer.init(line->text, true);
+		while (lexer.getNext()) {
+			if (lexer.getToken() == Token::KW_REM)
+				break;
+			// Line number constant, marked by the 2-nd tokenization
+			// pass
+			if (line->text[start] == ASCII_DLE &&
+			    line->text[start+1] == BASIC_TOKEN_C_LINENUM) {
+				const Line *target = lineByNumber(
+				    Integer(lexer.getValue()));
+				const uint16_t address = target != nullptr ?
+				    objectIndex(target) :
+				    BASIC_LEXER_NOT_LINKED;
+				writeValue(address, line->text +
+				    lexer.getPointer() - sizeof(uint16_t));
+			}
+			start = lexer.getPointer();
+		}
+		index += line->size;
+	}
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+	_linked = true;
+}
+
+Program::Line*
+Program::linkedLine(
+    uint16_t number,
+    uint16_t address)
+{
+	if (!_linked || address == BASIC_LEXER_NOT_LINKED)
+		return lineByNumber(number);
+
+	Line *result = lineByIndex(address);
+	_current.index = address + result->size;
+	_current.position = 0;
+	return result;
+}
+#endif // FAST_LINE_JUMP
+
+#if FAST_VARIABLE_ACCESS
+VariableFrame*
+Program::boundVariable(uint16_t address)
+{
+	if (!_variablesBound || address == BASIC_LEXER_NOT_LINKED)
+		return nullptr;
+	return reinterpret_cast<VariableFrame*>(_text + _textEnd + address);
+}
+#endif // FAST_VARIABLE_ACCESS
+
+#if CONF_LINE_INDEX
+void
+Program::invalidateLineIndex()
+{
+	_lineIndexStep = 0;
+}
+
+void
+Program::buildLineIndex()
+{
+	uint16_t lines = 0;
+	Pointer index;
+	for (index = 0; index < linesEnd();
+	    index += lineByIndex(index)->size)
+		++lines;
+	_lineIndexStep = (lines + LINE_INDEX_SIZE - 1) / LINE_INDEX_SIZE;
+	if (_lineIndexStep == 0)
+		_lineIndexStep = 1;
+
+	_lineIndexCount = 0;
+	lines = 0;
+	for (index = 0; index < linesEnd();
+	    index += lineByIndex(index)->size) {
+		if (lines++ % _lineIndexStep == 0)
+			_lineIndex[_lineIndexCount++] = index;
+	}
+}
+
+void
+Program::updateLineIndex(
+    Pointer index,
+    int16_t dist,
+    int8_t lines)
+{
+	if (_lineIndexStep == 0)
+		return;
+	// Sparse index entries can't be added or removed in place
+	if (lines != 0 && _lineIndexStep != 1) {
+		invalidateLineIndex();
+		return;
+	}
+
+	uint8_t i = 0;
+	while (i < _lineIndexCount && _lineIndex[i] < index)
+		++i;
+	if (lines > 0) {
+		if (_lineIndexCount >= LINE_INDEX_SIZE) {
+			invalidateLineIndex();
+			return;
+		}
+		memmove(&_lineIndex[i+1], &_lineIndex[i],
+		    (_lineIndexCount-i)*sizeof(Pointer));
+		++_lineIndexCount;
+		_lineIndex[i++] = index;
+	} else if (lines < 0) {
+		--_lineIndexCount;
+		memmove(&_lineIndex[i], &_lineIndex[i+1],
+		    (_lineIndexCount-i)*sizeof(Pointer));
+	} else if (i < _lineIndexCount && _lineIndex[i] == index)
+		++i;
+	// Shift addresses of the following lines
+	for (; i < _lineIndexCount; ++i)
+		_lineIndex[i] += dist;
+}
+
+Pointer
+Program::lineIndexLookup(uint16_t number)
+{
+	if (_lineIndexStep == 0)
+		buildLineIndex();
+
+	uint8_t lo = 0, hi = _lineIndexCount;
+	while (lo < hi) {
+		const uint8_t mid = (lo + hi) / 2;
+		if (READ_VALUE(lineByIndex(_lineIndex[mid])->number) <= number)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo > 0 ? _lineIndex[lo-1] : 0;
+}
+#endif // CONF_LINE_INDEX
+
 uint8_t
 Program::StackFrame::size(Type t)
 {
@@ -173,18 +352,70 @@ Program::clearProg()
 void
 Program::moveData(Pointer dest)
 {
+#if EXTMEMFS_STREAM
+	detachTextStorage();
+#endif
+#if CONF_TEXT_GAP
+	closeGap();
+#endif
 	const int32_t diff = _textEnd-dest;
 	memmove(_text+dest, _text+_textEnd, _arraysEnd-_textEnd);
 	_variablesEnd -= diff;
 	_arraysEnd -= diff;
 	_textEnd = dest;
+#if CONF_LINE_INDEX
+	invalidateLineIndex();
+#endif
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	invalidateForSkipCache();
+#endif
+#if CONF_LINE_SKIP_CACHE
+	invalidateLineSkipCache();
+#endif
+#if CONF_BYTECODE
+	invalidateBytecode();
+#endif
+#if FAST_LINE_JUMP
+	_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+	_variablesBound = false;
+#endif
+#if CONF_FAST_APPEND
+	_lastKnown = false;
+#endif
 }
 
 void
 Program::newProg()
 {
+#if EXTMEMFS_STREAM
+	detachTextStorage();
+#endif
 	clearProg();
 	_textEnd = _variablesEnd = _arraysEnd = _jump = 0;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	invalidateVariableIndex();
+#endif
+#if CONF_ARRAY_CACHE
+	invalidateArrayCache();
+#endif
+#if CONF_LINE_INDEX
+	invalidateLineIndex();
+#endif
+#if FAST_LINE_JUMP
+	_linked = false;
+#endif
+#if CONF_TEXT_GAP
+	_gapSize = 0;
+#endif
+#if CONF_FAST_APPEND
+	_lastKnown = false;
+#endif
 #if CLEAR_PROGRAM_MEMORY
 	memset(_text, 0xFF, programSize);
 #endif
@@ -193,6 +424,16 @@ Program::newProg()
 VariableFrame*
 Program::variableByName(const char *name)
 {
+#if CONF_VARIABLE_INDEX
+	// Frames are not moved relative to the text end, while index is valid
+	Pointer &entry =
+	    _variableIndex[nameHash(name) % VARIABLE_INDEX_SIZE];
+	if (entry != VARIABLE_NOT_INDEXED) {
+		VariableFrame *f = variableByIndex(_textEnd + entry);
+		if (f != nullptr && strncmp(name, f->name, VARSIZE) == 0)
+			return f;
+	}
+#endif
 	auto index = _textEnd;
 
 	VariableFrame* f;
@@ -207,9 +448,12 @@ Program::variableByName(const char *name)
 		if (!(f->type & TYPE_DEFFN)) {
 #endif
 			const int8_t res = strncmp(name, f->name, VARSIZE);
-			if (res == 0)
+			if (res == 0) {
+#if CONF_VARIABLE_INDEX
+				entry = index - _textEnd;
+#endif
 				return f;
-			else if (res < 0)
+			} else if (res < 0)
 				break;
 #if USE_DEFFN
 		}
@@ -243,20 +487,48 @@ Program::functionByName(const char *name)
 Pointer
 Program::objectIndex(const void *obj) const
 {
+#if EXTMEMFS_STREAM
+	// Lines of the external text are in the cache
+	if (_storage != nullptr) {
+		const uint8_t *p = reinterpret_cast<const uint8_t*>(obj);
+		for (uint8_t i = 0; i < LINE_CACHE_SIZE; ++i) {
+			const LineCacheEntry &entry = _lineCache[i];
+			if (p >= entry.line && p < entry.line +
+			    sizeof(entry.line))
+				return entry.index + (p - entry.line);
+		}
+	}
+#endif
 	return reinterpret_cast<const char*>(obj) - _text;
 }
 
 Program::StackFrame*
 Program::push(StackFrame::Type t)
 {
+#if CONF_PACKED_STRINGS
+	return push(t, StackFrame::size(t));
+}
+
+Program::StackFrame*
+Program::push(StackFrame::Type t, uint8_t s)
+{
+#else
 	const uint8_t s = StackFrame::size(t);
+#endif
 	if ((_sp - s) < _arraysEnd)
 		return nullptr;
 
 	_sp -= s;
 	StackFrame *f = stackFrameByIndex(_sp);
-	if (f != nullptr)
+	if (f != nullptr) {
 		f->_type = t;
+#if CONF_GOSUB_LINK
+		if (t == StackFrame::SUBPROGRAM_RETURN) {
+			WRITE_VALUE(f->body.gosubReturn.previous, _gosubSP);
+			_gosubSP = _sp;
+		}
+#endif
+	}
 	return f;
 }
 
@@ -264,39 +536,43 @@ void
 Program::pop()
 {
 	const StackFrame *f = stackFrameByIndex(_sp);
-	if (f != nullptr)
-		_sp += StackFrame::size(f->_type);
+	if (f != nullptr) {
+#if CONF_GOSUB_LINK
+		if (f->_type == StackFrame::SUBPROGRAM_RETURN)
+			_gosubSP = READ_VALUE(f->body.gosubReturn.previous);
+#endif
+		_sp += f->size();
+	}
 }
 
-void
-Program::reverseLast(StackFrame::Type type)
+#if CONF_GOSUB_LINK
+Program::StackFrame*
+Program::unwindToSubprogram()
 {
-	StackFrame *f = this->currentStackFrame();
-	if (f != nullptr && f->_type == type) {
-		char buf[sizeof (StackFrame)];
-		StackFrame *fr = reinterpret_cast<StackFrame*> (buf);
-		memcpy(fr, f, StackFrame::size(f->_type));
-		this->pop();
-		reverseLast(type);
-		pushBottom(fr);
-	}
+	if (_gosubSP >= programSize)
+		return nullptr;
+	_sp = _gosubSP;
+	return stackFrameByIndex(_sp);
 }
+#endif
 
 void
-Program::pushBottom(StackFrame *f)
+Program::reverseLast(StackFrame::Type type)
 {
-	auto newFrame = this->currentStackFrame();
-	if ((newFrame == nullptr) || (newFrame->_type != f->_type)) {
-		newFrame = this->push(f->_type);
-		memcpy(newFrame, f, StackFrame::size(f->_type));
-	} else {
-		char buf[sizeof (StackFrame)];
-		auto fr = reinterpret_cast<StackFrame*> (buf);
-		memcpy(fr, newFrame, StackFrame::size(f->_type));
-		this->pop();
-		pushBottom(f);
-		f = this->push(newFrame->_type);
-		memcpy(f, fr, StackFrame::size(newFrame->_type));
+	// Frames of the same type have the same size, they are swapped in place
+	const uint8_t size = StackFrame::size(type);
+	Pointer low = _sp, high = _sp;
+	while (high < programSize && stackFrameByIndex(high)->_type == type)
+		high += size;
+
+	while (high - low > size) {
+		high -= size;
+		for (uint8_t i = 0; i < size; ++i) {
+			const uint8_t b = _text[low + i];
+			_text[low + i] = _text[high + i];
+			_text[high + i] = b;
+		}
+		low += size;
 	}
 }
 
@@ -373,14 +649,83 @@ Program::addLine(
 	size = lexer.tokenize(tempBuffer, 2*PROGSTRINGSIZE, line);
         
 	// 2-nd pass tokenization: command calls translated into command
-	//  implementation asddress
-#if FAST_MODULE_CALL
+	//  implementation asddress, jump targets get space for line address,
+	//  scalar variables get space for variable frame address
+#if FAST_MODULE_CALL || FAST_LINE_JUMP || FAST_VARIABLE_ACCESS
 	lexer.init(tempBuffer, true);
+#if FAST_LINE_JUMP
+	bool jumpTarget = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+	// Identifiers of DATA and MAT statements are not bound
+	bool unbound = false;
+#endif
 	while (lexer.getNext()) {
 		const auto token = lexer.getToken();
 		if (token == Token::KW_REM)
 			break;
-		else if (token >= Token::INTEGER_IDENT &&
+#if FAST_LINE_JUMP
+		// Line number constant, which is the whole GOTO, GOSUB, THEN or
+		// ON ... GOTO list operand
+		if (token == Token::C_INTEGER && jumpTarget) {
+			const uint8_t pos = lexer.getPointer();
+			const bool last = tempBuffer[pos] == ASCII_NUL ||
+			    (tempBuffer[pos] == ASCII_DLE &&
+			     (tempBuffer[pos+1] == BASIC_TOKEN_COLON ||
+			      tempBuffer[pos+1] == BASIC_TOKEN_COMMA));
+			if (last &&
+			    size + sizeof(uint16_t) <= 2*PROGSTRINGSIZE) {
+				memmove(tempBuffer+pos+sizeof(uint16_t),
+				    tempBuffer+pos, size-pos);
+				size += sizeof(uint16_t);
+				tempBuffer[pos-sizeof(Integer)-1] =
+				    BASIC_TOKEN_C_LINENUM;
+				writeValue(uint16_t(BASIC_LEXER_NOT_LINKED),
+				    &tempBuffer[pos]);
+				lexer.setPointer(pos+sizeof(uint16_t));
+				continue;
+			}
+		}
+		jumpTarget = token == Token::KW_GOTO ||
+		    token == Token::KW_GOSUB || token == Token::KW_THEN ||
+		    (token == Token::COMMA && jumpTarget);
+#endif // FAST_LINE_JUMP
+#if FAST_VARIABLE_ACCESS
+		if (token == Token::COLON)
+			unbound = false;
+#if USE_DATA
+		else if (token == Token::KW_DATA)
+			unbound = true;
+#endif
+#if USE_MATRIX
+		else if (token == Token::KW_MAT)
+			unbound = true;
+#endif
+		// Scalar variable identifier: " NAME" is replaced by
+		// DLE, VARIABLE, frame address, NAME
+		if (token >= Token::INTEGER_IDENT &&
+		    token <= Token::BOOL_IDENT && !unbound) {
+			const uint8_t pos = lexer.getPointer();
+			const uint8_t start = pos - strlen(lexer.id()) - 1;
+			if (tempBuffer[start] == ' ' &&
+			    !(tempBuffer[pos] == ASCII_DLE &&
+			      tempBuffer[pos+1] == BASIC_TOKEN_LPAREN) &&
+			    parser.getCommand(lexer.id()) == nullptr &&
+			    size + sizeof(uint16_t) + 1 <= 2*PROGSTRINGSIZE) {
+				memmove(tempBuffer+start+sizeof(uint16_t)+2,
+				    tempBuffer+start+1, size-start-1);
+				size += sizeof(uint16_t) + 1;
+				tempBuffer[start] = ASCII_DLE;
+				tempBuffer[start+1] = BASIC_TOKEN_VARIABLE;
+				writeValue(uint16_t(BASIC_LEXER_NOT_LINKED),
+				    &tempBuffer[start+2]);
+				lexer.setPointer(pos+sizeof(uint16_t)+1);
+				continue;
+			}
+		}
+#endif // FAST_VARIABLE_ACCESS
+#if FAST_MODULE_CALL
+		if (token >= Token::INTEGER_IDENT &&
 		    token <= Token::BOOL_IDENT) {
 			auto c = parser.getCommand(lexer.id());
 			if (c != nullptr) {
@@ -397,28 +742,54 @@ Program::addLine(
 				lexer.setPointer(lexer.getPointer()-dist);
 			}
 		}
-	}
 #endif // FAST_MODULE_CALL
+	}
+#endif // FAST_MODULE_CALL || FAST_LINE_JUMP || FAST_VARIABLE_ACCESS
 
-	return addLine(num, tempBuffer, size);
+#if CONF_LINE_CHECK
+	bool ok;
+	const bool checked = parser.check(tempBuffer, ok);
+#else
+	const bool checked = false;
+#endif
+	return addLine(num, tempBuffer, size, checked);
 }
 
 bool
 Program::addLine(
     uint16_t num,
     const uint8_t *text,
-    uint8_t len)
+    uint8_t len,
+    bool checked)
 {
-	reset();
+	_reset();
+#if EXTMEMFS_STREAM
+	// External program text is read only
+	if (_storage != nullptr)
+		return false;
+#endif
 
 	if (_textEnd == 0) // First string insertion
-		return insert(num, text, len);
+		return insert(num, text, len, checked);
+#if CONF_FAST_APPEND
+	if (_lastKnown && num > _lastNumber) {
+		// Append after the last line
+		_current.index = _textEnd;
+		return insert(num, text, len, checked);
+	}
+#endif
 
 	const uint8_t strLen = sizeof(Line) + len;
 	// Iterate over lines
 	Line *cur;
 	for (cur = current(_current); _current.index < _textEnd;
 	    cur = current(_current)) {
+#if CONF_TEXT_GAP
+		if (_gapSize > 0 && _current.index == _gapStart) {
+			_current.index += _gapSize;
+			continue;
+		}
+#endif
 		const auto curnumber = READ_VALUE(cur->number);
 		if (num < curnumber) {
 			// Current line has number greater then new one,
@@ -427,6 +798,29 @@ Program::addLine(
 		} else if (num == curnumber) {
 			// Current line has number equals to new one,
 			// replace string
+			if (cur->size == strLen) {
+				// Same size line is copied in place, nothing
+				// is moved
+#if CONF_LINE_CHECK
+				cur->checked = checked;
+#endif
+				memcpy(cur->text, text, len);
+#if FAST_LINE_JUMP
+				_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+				_variablesBound = false;
+#endif
+				return true;
+			}
+#if CONF_TEXT_GAP
+			// Old line joins the gap, new one is inserted
+			const uint8_t curSize = cur->size;
+			moveGap(_current.index);
+			_gapSize += curSize;
+			_current.index = _gapStart;
+			break;
+#else
 			const uint8_t newSize = strLen;
 			const uint8_t curSize = cur->size;
 			const int8_t dist = newSize - curSize;
@@ -438,23 +832,84 @@ Program::addLine(
 			    _text + _current.index + curSize, bytes2copy);
 			WRITE_VALUE(cur->number, num);
 			cur->size = strLen;
+#if CONF_LINE_CHECK
+			cur->checked = checked;
+#endif
 			memcpy(cur->text, text, len);
 			_textEnd += dist, _variablesEnd += dist,
 			    _arraysEnd += dist;
+#if CONF_LINE_INDEX
+			updateLineIndex(_current.index, dist, 0);
+#endif
+#if FAST_LINE_JUMP
+			_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+			_variablesBound = false;
+#endif
 #if CONF_USE_ALIGN
 			return alignVars(_textEnd);
 #else
 			return true;
 #endif
+#endif // CONF_TEXT_GAP
 		}
 		_current.index += cur->size;
 	}
-	return insert(num, text, len);
+	return insert(num, text, len, checked);
 }
 
 void
 Program::removeLine(uint16_t num)
 {
+#if EXTMEMFS_STREAM
+	// External program text is read only
+	if (_storage != nullptr)
+		return;
+#endif
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	invalidateForSkipCache();
+#endif
+#if CONF_LINE_SKIP_CACHE
+	invalidateLineSkipCache();
+#endif
+#if CONF_BYTECODE
+	invalidateBytecode();
+#endif
+#if CONF_TEXT_GAP
+	for (Pointer index = 0; index < _textEnd;) {
+		if (_gapSize > 0 && index == _gapStart) {
+			index += _gapSize;
+			continue;
+		}
+		const Line *line = lineByIndex(index);
+		const uint16_t number = READ_VALUE(line->number);
+		if (number == num) {
+			// Removed line joins the gap
+			const uint8_t size = line->size;
+			moveGap(index);
+			_gapSize += size;
+#if CONF_LINE_INDEX
+			invalidateLineIndex();
+#endif
+#if FAST_LINE_JUMP
+			_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+			_variablesBound = false;
+#endif
+#if CONF_FAST_APPEND
+			_lastKnown = false;
+#endif
+			return;
+		} else if (number > num)
+			return;
+		index += line->size;
+	}
+#else
 	const Line *line = this->lineByNumber(num, 0);
 	if (line != nullptr) {
 		const Pointer index = objectIndex(line);
@@ -465,20 +920,59 @@ Program::removeLine(uint16_t num)
 		_variablesEnd -= line->size;
 		_arraysEnd -= line->size;
 		memmove(_text+index, _text+next, len);
+#if CONF_LINE_INDEX
+		updateLineIndex(index, -int16_t(next-index), -1);
+#endif
+#if FAST_LINE_JUMP
+		_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+		_variablesBound = false;
+#endif
+#if CONF_FAST_APPEND
+		_lastKnown = false;
+#endif
 #if CONF_USE_ALIGN
 		alignVars(_textEnd);
 #endif
 	}
+#endif // CONF_TEXT_GAP
 }
 
 bool
 Program::insert(
     uint16_t num,
     const uint8_t *text,
-    uint8_t len)
+    uint8_t len,
+    bool checked)
 {
 	const uint8_t strLen = sizeof(Line) + len;
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	invalidateForSkipCache();
+#endif
+#if CONF_LINE_SKIP_CACHE
+	invalidateLineSkipCache();
+#endif
+#if CONF_BYTECODE
+	invalidateBytecode();
+#endif
+#if CONF_FAST_APPEND
+	// Insertion after all lines, including the first one
+	const bool append = _current.index >= _textEnd;
+#endif
+
+#if CONF_TEXT_GAP
+	moveGap(_current.index);
+	if (_gapSize < strLen && !growGap(strLen - _gapSize))
+		return false;
 
+	Line *cur = lineByIndex(_gapStart);
+	_gapStart += strLen;
+	_gapSize -= strLen;
+#else
 	if (_arraysEnd + strLen >= _sp)
 		return false;
 
@@ -486,23 +980,153 @@ Program::insert(
 	    _arraysEnd - _current.index);
 
 	Line *cur = lineByIndex(_current.index);
+#endif // CONF_TEXT_GAP
 	WRITE_VALUE(cur->number, num);
 	cur->size = strLen;
+#if CONF_LINE_CHECK
+	cur->checked = checked;
+#else
+	(void)checked;
+#endif
 	memcpy(cur->text, text, len);
+#if FAST_LINE_JUMP
+	_linked = false;
+#endif
+#if FAST_VARIABLE_ACCESS
+	_variablesBound = false;
+#endif
+#if CONF_FAST_APPEND
+	if (append) {
+		_lastNumber = num;
+		_lastKnown = true;
+	}
+#endif
+#if CONF_TEXT_GAP
+#if CONF_LINE_INDEX
+	invalidateLineIndex();
+#endif
+	return true;
+#else
 	_textEnd += strLen, _variablesEnd += strLen, _arraysEnd += strLen;
+#if CONF_LINE_INDEX
+	updateLineIndex(_current.index, strLen, 1);
+#endif
 #if CONF_USE_ALIGN
 	return alignVars(_textEnd);
 #else
 	return true;
 #endif
+#endif // CONF_TEXT_GAP
+}
+
+#if CONF_TEXT_GAP
+void
+Program::closeGap()
+{
+	if (_gapSize == 0)
+		return;
+
+	const Pointer gapEnd = _gapStart + _gapSize;
+	memmove(_text + _gapStart, _text + gapEnd, _arraysEnd - gapEnd);
+	_textEnd -= _gapSize, _variablesEnd -= _gapSize,
+	    _arraysEnd -= _gapSize;
+	_gapSize = 0;
+#if CONF_LINE_INDEX
+	invalidateLineIndex();
+#endif
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	invalidateForSkipCache();
+#endif
+#if CONF_LINE_SKIP_CACHE
+	invalidateLineSkipCache();
+#endif
+#if CONF_BYTECODE
+	invalidateBytecode();
+#endif
+#if CONF_USE_ALIGN
+	alignVars(_textEnd);
+#endif
+}
+
+void
+Program::moveGap(Pointer index)
+{
+	if (_gapSize == 0) {
+		_gapStart = index;
+		return;
+	}
+
+	const Pointer gapEnd = _gapStart + _gapSize;
+	if (index < _gapStart) {
+		// Lines between index and gap are moved after the gap
+		memmove(_text + index + _gapSize, _text + index,
+		    _gapStart - index);
+		_gapStart = index;
+	} else if (index >= gapEnd) {
+		// Lines between gap and index are moved before the gap
+		memmove(_text + _gapStart, _text + gapEnd, index - gapEnd);
+		_gapStart += index - gapEnd;
+	}
+}
+
+bool
+Program::growGap(Pointer size)
+{
+	Pointer add = size < TEXT_GAP_SIZE ? TEXT_GAP_SIZE : size;
+#if CONF_USE_ALIGN
+	// Data is moved by the multiple of the largest value alignment
+	add = (add + sizeof(uint64_t) - 1) & ~Pointer(sizeof(uint64_t) - 1);
+	size = (size + sizeof(uint64_t) - 1) & ~Pointer(sizeof(uint64_t) - 1);
+#endif
+	if (_arraysEnd + add >= _sp)
+		add = size;
+	if (_arraysEnd + add >= _sp)
+		return false;
+
+	const Pointer gapEnd = _gapStart + _gapSize;
+	memmove(_text + gapEnd + add, _text + gapEnd, _arraysEnd - gapEnd);
+	_gapSize += add;
+	_textEnd += add, _variablesEnd += add, _arraysEnd += add;
+	return true;
 }
+#endif // CONF_TEXT_GAP
 
 void
 Program::reset(Pointer size)
 {
-	_reset();
+#if CONF_TEXT_GAP
+	// Text size argument includes the gap
 	if (size > 0)
+		size -= _gapSize;
+	closeGap();
+#endif
+	_reset();
+	if (size > 0) {
+#if CONF_LINE_INDEX || FAST_LINE_JUMP || CONF_FAST_APPEND
+		if (size != _textEnd) {
+#if CONF_LINE_INDEX
+			invalidateLineIndex();
+#endif
+#if FAST_LINE_JUMP
+			_linked = false;
+#endif
+#if CONF_FAST_APPEND
+			_lastKnown = false;
+#endif
+		}
+#endif
 		_textEnd = _variablesEnd = _arraysEnd = size;
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+		invalidateVariableIndex();
+#endif
+#if CONF_ARRAY_CACHE
+		invalidateArrayCache();
+#endif
+	}
 }
 
 Pointer
@@ -519,12 +1143,282 @@ Program::_reset()
 	_dataCurrent.index = _dataCurrent.position = 0;
 #endif
 	_sp = programSize;
+#if CONF_GOSUB_LINK
+	_gosubSP = programSize;
+#endif
+#if CONF_EVAL_STACK
+	_evalDepth = 0;
+#endif
+#if CONF_LINE_CACHE
+	invalidateLineCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	invalidateForSkipCache();
+#endif
+#if CONF_LINE_SKIP_CACHE
+	invalidateLineSkipCache();
+#endif
+#if CONF_BYTECODE
+	invalidateBytecode();
+#endif
+}
+
+#if EXTMEMFS_STREAM
+void
+Program::setTextStorage(
+    TextStorage *storage,
+    Pointer size)
+{
+	newProg();
+	_storage = storage;
+	_storageEnd = size;
+#if CONF_LINE_INDEX
+	buildLineIndex();
+#endif
+}
+
+void
+Program::detachTextStorage()
+{
+	if (_storage == nullptr)
+		return;
+	_storage->close();
+	_storage = nullptr;
+	invalidateLineCache();
+#if CONF_LINE_INDEX
+	invalidateLineIndex();
+#endif
+}
+#endif // EXTMEMFS_STREAM
+
+#if CONF_FOR_SKIP_CACHE
+void
+Program::invalidateForSkipCache()
+{
+	for (uint8_t i = 0; i < FOR_SKIP_CACHE_SIZE; ++i)
+		_forSkipCache[i].loop.index = FOR_NOT_CACHED;
+	_skippedFor.index = FOR_NOT_CACHED;
+}
+
+const Program::Position*
+Program::forSkipTarget(const Position &loop) const
+{
+	const ForSkipEntry &e = _forSkipCache[(loop.index + loop.position) %
+	    FOR_SKIP_CACHE_SIZE];
+	if (e.loop.index == loop.index && e.loop.position == loop.position)
+		return &e.next;
+	return nullptr;
+}
+
+void
+Program::setForSkipTarget(const Position &loop, const Position &next)
+{
+	ForSkipEntry &e = _forSkipCache[(loop.index + loop.position) %
+	    FOR_SKIP_CACHE_SIZE];
+	e.loop = loop;
+	e.next = next;
+}
+#endif // CONF_FOR_SKIP_CACHE
+
+#if CONF_LINE_SKIP_CACHE
+void
+Program::invalidateLineSkipCache()
+{
+	for (uint8_t i = 0; i < LINE_SKIP_CACHE_SIZE; ++i)
+		_lineSkipCache[i].index = LINE_SKIP_NOT_CACHED;
+}
+
+bool
+Program::lineSkipCached(const Position &pos) const
+{
+	const Position &e = _lineSkipCache[(pos.index + pos.position) %
+	    LINE_SKIP_CACHE_SIZE];
+	return e.index == pos.index && e.position == pos.position;
+}
+
+void
+Program::setLineSkip(const Position &pos)
+{
+	_lineSkipCache[(pos.index + pos.position) % LINE_SKIP_CACHE_SIZE] =
+	    pos;
+}
+#endif // CONF_LINE_SKIP_CACHE
+
+#if CONF_BYTECODE
+void
+Program::invalidateBytecode()
+{
+	for (uint8_t i = 0; i < BYTECODE_CACHE_SIZE; ++i) {
+		_bytecode[i].position.index = BYTECODE_NOT_CACHED;
+		_bytecode[i].used = false;
+	}
+}
+
+Program::BytecodeEntry*
+Program::bytecodeEntry(const Position &pos)
+{
+	const Pointer hash = (pos.index ^ (pos.index >> 4)) + pos.position;
+	BytecodeEntry *set = &_bytecode[hash %
+	    (BYTECODE_CACHE_SIZE / BYTECODE_WAYS) * BYTECODE_WAYS];
+	for (uint8_t i = 0; i < BYTECODE_WAYS; ++i) {
+		if (set[i].position.index == pos.index &&
+		    set[i].position.position == pos.position)
+			return &set[i];
+	}
+	for (uint8_t i = 0; i < BYTECODE_WAYS; ++i) {
+		if (!set[i].used)
+			return &set[i];
+	}
+	// Second chance: entries are replaced by the next miss, if they are
+	// not executed before it
+	for (uint8_t i = 0; i < BYTECODE_WAYS; ++i)
+		set[i].used = false;
+	return nullptr;
+}
+#endif // CONF_BYTECODE
+
+#if CONF_LINE_CACHE
+void
+Program::invalidateLineCache()
+{
+	for (uint8_t i = 0; i < LINE_CACHE_SIZE; ++i)
+		_lineCache[i].index = LINE_NOT_CACHED;
+	_lineCachePinned = LINE_CACHE_SIZE;
+}
+
+Program::Line*
+Program::cachedLine(Pointer index)
+{
+	const uint16_t clock = ++_lineCacheClock;
+	uint8_t victim = 0;
+	uint16_t victimAge = 0;
+	for (uint8_t i = 0; i < LINE_CACHE_SIZE; ++i) {
+		LineCacheEntry &entry = _lineCache[i];
+		if (entry.index == index) {
+			entry.stamp = clock;
+			return reinterpret_cast<Line*>(entry.line);
+		}
+		// Line being parsed is not replaced
+		if (i == _lineCachePinned)
+			continue;
+		// Free or least recently used entry will be replaced
+		const uint16_t age = entry.index == LINE_NOT_CACHED ?
+		    UINT16_MAX : uint16_t(clock - entry.stamp);
+		if (age >= victimAge)
+			victim = i, victimAge = age;
+	}
+
+	LineCacheEntry &entry = _lineCache[victim];
+	Line *line = reinterpret_cast<Line*>(entry.line);
+#if EXTMEMFS_STREAM
+	if (_storage != nullptr) {
+		if (!_storage->readLine(index, line, sizeof(entry.line))) {
+			entry.index = LINE_NOT_CACHED;
+			return nullptr;
+		}
+	} else
+#endif
+	{
+		const Line *src = lineByIndex(index);
+		if (src->size > sizeof(entry.line))
+			return const_cast<Line*>(src);
+		memcpy(line, src, src->size);
+	}
+	entry.index = index;
+	entry.stamp = clock;
+	return line;
+}
+
+const uint8_t*
+Program::cachedLineText(Pointer index)
+{
+	Line *line = cachedLine(index);
+	if (line == nullptr)
+		return nullptr;
+	_lineCachePinned = LINE_CACHE_SIZE;
+	for (uint8_t i = 0; i < LINE_CACHE_SIZE; ++i) {
+		if (_lineCache[i].index == index) {
+			_lineCachePinned = i;
+			break;
+		}
+	}
+	return line->text;
+}
+#endif // CONF_LINE_CACHE
+
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+void
+Program::invalidateVariableIndex()
+{
+#if CONF_VARIABLE_INDEX
+	for (uint8_t i = 0; i < VARIABLE_INDEX_SIZE; ++i)
+		_variableIndex[i] = VARIABLE_NOT_INDEXED;
+#endif
+#if FAST_VARIABLE_ACCESS
+	_variablesBound = false;
+#endif
+#if CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	++_variablesLayout;
+#endif
+}
+#endif // CONF_VARIABLE_INDEX || ... || CONF_BYTECODE
+
+#if CONF_ARRAY_CACHE
+void
+Program::invalidateArrayCache()
+{
+	for (uint8_t i = 0; i < ARRAY_CACHE_SIZE; ++i)
+		_arrayCache[i].offset = ARRAY_NOT_CACHED;
 }
 
+const Program::ArrayDescriptor*
+Program::arrayDescriptor(const char *name)
+{
+	// Frames are not moved relative to the variables end, while the cache
+	// is valid
+	ArrayDescriptor &d = _arrayCache[nameHash(name) % ARRAY_CACHE_SIZE];
+	if (d.offset != ARRAY_NOT_CACHED && strncmp(name,
+	    arrayByDescriptor(d)->name, VARSIZE) == 0)
+		return &d;
+
+	const ArrayFrame *f = arrayByName(name);
+	if (f == nullptr || f->numDimensions > ARRAY_CACHE_DIMENSIONS)
+		return nullptr;
+	d.offset = objectIndex(f) - _variablesEnd;
+	d.numDimensions = f->numDimensions;
+	uint16_t stride = 1;
+	for (uint8_t dim = f->numDimensions; dim-- > 0;) {
+		d.dimension[dim] = f->dimension[dim];
+		d.stride[dim] = stride;
+		stride *= f->dimension[dim] + 1;
+	}
+	return &d;
+}
+#endif // CONF_ARRAY_CACHE
+
+#if CONF_VARIABLE_INDEX || CONF_ARRAY_CACHE
+uint8_t
+Program::nameHash(const char *name)
+{
+	uint8_t hash = 0;
+	for (uint8_t i = 0; i < VARSIZE && name[i] != '\0'; ++i)
+		hash = uint8_t(hash << 1) ^ uint8_t(name[i]);
+	return hash;
+}
+#endif // CONF_VARIABLE_INDEX || CONF_ARRAY_CACHE
+
 #if CONF_USE_ALIGN
 bool
 Program::alignVars(Pointer index)
 {
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	invalidateVariableIndex();
+#endif
+#if CONF_ARRAY_CACHE
+	invalidateArrayCache();
+#endif
 	Pointer lastIndex = index;
 	VariableFrame *f;
 	while ((f = variableByIndex(index)) != nullptr) {
@@ -539,6 +1433,7 @@ Program::alignVars(Pointer index)
 		}
 #endif
 		const Parser::Value::Type t = f->type;
+		const uint8_t size = f->size();
 		Pointer i = lastIndex + sizeof(VariableFrame);
 		int8_t a = alignPointer(i, t);
 		int8_t dist = a - int8_t(index - lastIndex);
@@ -558,7 +1453,7 @@ Program::alignVars(Pointer index)
 		
 		alignVars(_variablesEnd);
 		
-		lastIndex += a + VariableFrame::size(t);
+		lastIndex += a + size;
 		index = lastIndex;
 	}
 	
@@ -568,6 +1463,9 @@ Program::alignVars(Pointer index)
 bool
 Program::alignArrays(Pointer index)
 {
+#if CONF_ARRAY_CACHE
+	invalidateArrayCache();
+#endif
 	Pointer lastIndex = index;
 	ArrayFrame *f;
 	while ((f = arrayByIndex(index)) != nullptr) {
@@ -27,6 +27,10 @@
 #include "basic.hpp"
 #include "basic_parser_value.hpp"
 
+#if EXTMEMFS_STREAM && !CONF_LINE_CACHE
+#error Program text streaming requires line cache
+#endif
+
 namespace BASIC
 {
 
@@ -34,6 +38,7 @@ class VariableFrame;
 class ArrayFrame;
 class Interpreter;
 class Parser;
+class ExtmemFSModule;
 
 /**
  * @brief BASIC program in memory
@@ -41,6 +46,7 @@ class Parser;
 class Program
 {
 	friend class Interpreter;
+	friend class ExtmemFSModule;
 public:
 
 	/**
@@ -52,6 +58,10 @@ public:
 		uint16_t number;
 		// size in bytes
 		uint8_t size;
+#if CONF_LINE_CHECK
+		// line has no syntax errors and can be skipped without the scan
+		uint8_t checked;
+#endif
 		// string body
 		uint8_t text[];
 	};
@@ -108,6 +118,14 @@ public:
 			Parser::Value	stepValue;
 			// Loop final value
 			Parser::Value	finalvalue;
+#if CONF_FAST_FOR_NEXT
+			// Loop variable frame address relative to the text end
+			Pointer		varOffset;
+			// Variables layout stamp of the frame address
+			uint16_t	varLayout;
+			// INTEGER or REAL for the native loop, STRING otherwise
+			Parser::Value::Type nativeType;
+#endif
 		};
 		static_assert (sizeof (ForBody) <= UINT8_MAX, "bad size");
 
@@ -120,6 +138,10 @@ public:
 			Pointer calleeIndex;
 			// Position in the program string
 			uint8_t	textPosition;
+#if CONF_GOSUB_LINK
+			// Address of the previous subprogram return frame
+			Pointer previous;
+#endif
 		};
 
 		/**
@@ -137,7 +159,25 @@ public:
 
 		static uint8_t size(Type);
 
+#if CONF_PACKED_STRINGS
+		/**
+		 * @brief size of the string frame
+		 * @param length string length
+		 */
+		static uint8_t stringSize(uint8_t length)
+		{
+			return sizeof(StackFrame) - sizeof(Body) + length + 1;
+		}
+
+		uint8_t size() const
+		{
+			if (_type == STRING)
+				return stringSize(strlen(body.string));
+			return size(_type);
+		}
+#else
 		uint8_t size() const { return size(this->_type); }
+#endif
 
 		Type _type;
 
@@ -154,6 +194,28 @@ public:
 		Body body;
 	};
 
+#if EXTMEMFS_STREAM
+	/**
+	 * @brief External storage of the program text
+	 */
+	class TextStorage
+	{
+	public:
+		/**
+		 * @brief Read program line
+		 * @param index line address in the program text
+		 * @param line [out] line buffer
+		 * @param size buffer size
+		 * @return flag of success
+		 */
+		virtual bool readLine(Pointer, Line*, uint8_t) = 0;
+		/**
+		 * @brief Release the storage, program doesn't use it anymore
+		 */
+		virtual void close() = 0;
+	};
+#endif // EXTMEMFS_STREAM
+
 	Program(Pointer = SINGLE_PROGSIZE);
 	/**
 	 * @brief Clear program text, but not vars and arrays
@@ -212,6 +274,9 @@ public:
 	Line *lineByIndex(Pointer) const;
 	/**
 	 * @brief program line of given number
+	 *
+	 * Current position is set to the beginning of the line, next to
+	 * the found one
 	 * @param number Program line number to get
 	 * @param address start of the search
 	 * @return Line pointer or NULL if not found
@@ -219,6 +284,32 @@ public:
 	Line *lineByNumber(
 	    uint16_t,
 	    Pointer = 0);
+#if FAST_LINE_JUMP
+	/**
+	 * @brief Resolve addresses of the line number constants, following
+	 *   GOTO, GOSUB and THEN
+	 */
+	void link();
+	/**
+	 * @brief program line of given number, using address, resolved by
+	 *   the link pass, if it is still valid
+	 * @param number Program line number to get
+	 * @param address resolved line address
+	 * @return Line pointer or NULL if not found
+	 */
+	Line *linkedLine(
+	    uint16_t,
+	    uint16_t);
+#endif // FAST_LINE_JUMP
+#if FAST_VARIABLE_ACCESS
+	/**
+	 * @brief variable frame at the address, resolved by the RUN command,
+	 *   if bindings are still valid
+	 * @param address frame address, relative to the end of text
+	 * @return frame pointer or nullptr
+	 */
+	VariableFrame *boundVariable(uint16_t);
+#endif
 	/**
 	 * @brief get variable frame at a given index
 	 * @param index basic memory address
@@ -232,6 +323,102 @@ public:
 
 	ArrayFrame *arrayByIndex(Pointer);
 	ArrayFrame *arrayByName(const char*);
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief Cached array descriptor
+	 */
+	struct ArrayDescriptor
+	{
+		// Frame address, relative to the end of variables area,
+		// ARRAY_NOT_CACHED if entry is free
+		Pointer offset;
+		// Number of dimensions
+		uint8_t numDimensions;
+		// Maximal subscript of each dimension
+		uint16_t dimension[ARRAY_CACHE_DIMENSIONS];
+		// Number of elements, skipped by the unit step of each subscript
+		uint16_t stride[ARRAY_CACHE_DIMENSIONS];
+	};
+	/**
+	 * @brief get descriptor of the array with given name
+	 * @param name array name
+	 * @return descriptor or nullptr if there is no such array or it has
+	 *   more then ARRAY_CACHE_DIMENSIONS dimensions
+	 */
+	const ArrayDescriptor *arrayDescriptor(const char*);
+	/**
+	 * @brief get array frame of the descriptor
+	 * @param d valid array descriptor
+	 * @return frame pointer
+	 */
+	ArrayFrame *arrayByDescriptor(const ArrayDescriptor &d)
+	{
+		return reinterpret_cast<ArrayFrame*>(
+		    _text + _variablesEnd + d.offset);
+	}
+#endif // CONF_ARRAY_CACHE
+#if CONF_BYTECODE
+	/**
+	 * @brief Compiled statement operations. Operands follow the code
+	 */
+	enum Opcode : uint8_t
+	{
+		// Push constant, value operand
+		BC_CONST,
+		// Push variable value, 16-bit frame address operand
+		BC_VAR,
+		// Replace subscripts with array element value, number of
+		// subscripts and name operands
+		BC_ARRAY,
+		// Unary minus and NOT
+		BC_NEG,
+		// Binary operations on two top values
+		BC_ADD, BC_SUB, BC_MUL, BC_DIV, BC_IDIV, BC_MOD, BC_POW,
+		BC_LT, BC_LTE, BC_GT, BC_GTE, BC_EQ, BC_NE, BC_AND, BC_OR,
+		// Pop value to the variable, 16-bit frame address operand
+		BC_SET,
+		// Pop value and subscripts to the array element, number of
+		// subscripts and name operands
+		BC_SET_ARRAY,
+		// Pop condition, end the line if it is false
+		BC_IFNOT_EOL,
+		// Pop condition, skip number of bytes operand if it is false
+		BC_IFNOT_SKIP,
+		// Skip number of bytes operand, right operand of OR or AND,
+		// if the top value decides the result
+		BC_OR_SKIP, BC_AND_SKIP,
+		// Pop line number and jump, line address operand
+		BC_GOTO,
+		// Jump as THEN line number, execution continues
+		BC_THEN,
+		// Pop line number and call subprogram, line address and return
+		// position operands
+		BC_GOSUB,
+		BC_RETURN,
+		// Iterate FOR-loop, variable name operand
+		BC_NEXT,
+		// Statement end, position of the next statement operand
+		BC_COLON,
+		// Line end
+		BC_EOL
+	};
+	/**
+	 * @brief Compiled statement
+	 */
+	struct BytecodeEntry
+	{
+		// Statement position, index is BYTECODE_NOT_CACHED if entry is
+		// free
+		Position position;
+		// Variables layout stamp of the resolved frame addresses
+		uint16_t layout;
+		// Code size, 0 if statement can't be compiled
+		uint8_t size;
+		// Entry was executed after the last miss
+		bool used;
+		uint8_t code[BYTECODE_SIZE];
+	};
+#endif // CONF_BYTECODE
 
 	Pointer objectIndex(const void*) const;
 
@@ -242,10 +429,25 @@ public:
 	 * @param type
 	 */
 	StackFrame *push(StackFrame::Type);
+#if CONF_PACKED_STRINGS
+	/**
+	 * @brief push stack frame of the given size
+	 * @param type
+	 * @param size frame size in bytes
+	 */
+	StackFrame *push(StackFrame::Type, uint8_t);
+#endif
 	/**
 	 * @brief pop top stack frame
 	 */
 	void pop();
+#if CONF_GOSUB_LINK
+	/**
+	 * @brief drop frames above the last subprogram return frame
+	 * @return the frame or nullptr if no one
+	 */
+	StackFrame *unwindToSubprogram();
+#endif
 	/**
 	 * @brief reverse order of last same type elements
 	 */
@@ -270,11 +472,41 @@ public:
 	 * @param num line number
 	 * @param text line text
 	 * @param len line length
+	 * @param checked line was checked by the parser
 	 */
 	bool insert(
 	    uint16_t,
 	    const uint8_t*,
-	    uint8_t);
+	    uint8_t,
+	    bool);
+#if CONF_LINE_CACHE
+	/**
+	 * @brief Body of the program line to be parsed, copy in the line
+	 *   cache if possible. The line is kept in cache until the next call
+	 * @param index line address
+	 * @return line text or nullptr if the external text was not read
+	 */
+	const uint8_t *cachedLineText(Pointer);
+#endif
+#if EXTMEMFS_STREAM
+	/**
+	 * @brief Replace program text by the text in external storage.
+	 *   Program lines are read from it through the line cache. Storage is
+	 *   closed on NEW or program load
+	 * @param storage text storage
+	 * @param size text size
+	 */
+	void setTextStorage(TextStorage*, Pointer);
+
+	TextStorage *textStorage() const { return _storage; }
+#endif
+#if CONF_TEXT_GAP
+	/**
+	 * @brief Remove the editing gap from program text. Must be called
+	 *   before program text is read
+	 */
+	void closeGap();
+#endif
 
 #if CONF_USE_ALIGN
 	/**
@@ -299,16 +531,154 @@ public:
 private:
 
 	void _reset();
+	/**
+	 * @brief End of the program lines address space
+	 */
+	Pointer linesEnd() const
+	{
+#if EXTMEMFS_STREAM
+		if (_storage != nullptr)
+			return _storageEnd;
+#endif
+		return _textEnd;
+	}
+#if EXTMEMFS_STREAM
+	void detachTextStorage();
+#endif
 
-	void pushBottom(StackFrame*);
+#if CONF_TEXT_GAP
+	/**
+	 * @brief Move editing gap to the given line address
+	 * @param index line address
+	 */
+	void moveGap(Pointer);
+	/**
+	 * @brief Enlarge editing gap, moving variables and arrays
+	 * @param size minimal number of bytes to add
+	 * @return flag of success
+	 */
+	bool growGap(Pointer);
+#endif // CONF_TEXT_GAP
+#if CONF_LINE_INDEX
+	/**
+	 * @brief Mark line index as invalid, it will be rebuilt on next search
+	 */
+	void invalidateLineIndex();
+	/**
+	 * @brief Fill line index from the program text
+	 */
+	void buildLineIndex();
+	/**
+	 * @brief Update index after the line insertion, removal or resize
+	 * @param index line address
+	 * @param dist line size change
+	 * @param lines number of the lines added (1), removed (-1) or 0
+	 */
+	void updateLineIndex(Pointer, int16_t, int8_t);
+	/**
+	 * @brief Find nearest indexed line
+	 * @param number line number
+	 * @return address of the last indexed line with number not greater
+	 *   then given or 0
+	 */
+	Pointer lineIndexLookup(uint16_t);
+#endif // CONF_LINE_INDEX
+#if CONF_LINE_CACHE
+	/**
+	 * @brief Drop all cached lines, must be called on program text change
+	 */
+	void invalidateLineCache();
+	/**
+	 * @brief Program line copy in the line cache
+	 * @param index line address
+	 * @return line from cache, from program memory if it is too long, or
+	 *   nullptr if external storage read failed
+	 */
+	Line *cachedLine(Pointer);
+#endif
+#if CONF_VARIABLE_INDEX || FAST_VARIABLE_ACCESS || \
+    CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	/**
+	 * @brief Mark all variable index entries as free, drop variable
+	 *   bindings, FOR-loop variable addresses and compiled statements,
+	 *   must be called if variable frames are added, removed or aligned
+	 */
+	void invalidateVariableIndex();
+#endif
+#if CONF_ARRAY_CACHE
+	/**
+	 * @brief Mark all array cache entries as free, must be called if
+	 *   array frames are added, removed, resized or aligned
+	 */
+	void invalidateArrayCache();
+#endif
+#if CONF_FOR_SKIP_CACHE
+	/**
+	 * @brief Drop all cached FOR-loop skip targets and the loop being
+	 *   skipped, must be called on program text change
+	 */
+	void invalidateForSkipCache();
+	/**
+	 * @brief Position after the NEXT statement of the skipped loop
+	 * @param loop position after the FOR statement
+	 * @return cached position or nullptr
+	 */
+	const Position *forSkipTarget(const Position&) const;
+	/**
+	 * @brief Cache the position after the NEXT statement of the loop
+	 * @param loop position after the FOR statement
+	 * @param next position after the NEXT statement
+	 */
+	void setForSkipTarget(const Position&, const Position&);
+#endif
+#if CONF_LINE_SKIP_CACHE
+	/**
+	 * @brief Drop all cached line skips, must be called on program text
+	 *   change
+	 */
+	void invalidateLineSkipCache();
+	/**
+	 * @brief Check if the statement is known to skip the rest of the line
+	 * @param pos statement position
+	 */
+	bool lineSkipCached(const Position&) const;
+	/**
+	 * @brief Cache the statement, which skips the rest of the line
+	 * @param pos statement position
+	 */
+	void setLineSkip(const Position&);
+#endif
+#if CONF_BYTECODE
+	/**
+	 * @brief Drop all compiled statements, must be called on program
+	 *   text change
+	 */
+	void invalidateBytecode();
+	/**
+	 * @brief Cache entry of the statement
+	 * @param pos statement position
+	 * @return entry of the statement, entry to replace or nullptr if all
+	 *   entries of the set were executed after the last miss
+	 */
+	BytecodeEntry *bytecodeEntry(const Position&);
+#endif
+#if CONF_VARIABLE_INDEX || CONF_ARRAY_CACHE
+	/**
+	 * @brief Hash of the variable or array name
+	 * @param name variable name
+	 * @return hash value
+	 */
+	static uint8_t nameHash(const char*);
+#endif
 	/**
 	 * @brief Add tokenized program line
 	 * @param num line number
 	 * @param text line body w/o number
 	 * @param len line body length
+	 * @param checked line was checked by the parser
 	 * @return flag of success
 	 */
-	bool addLine(uint16_t, const uint8_t*, uint8_t);
+	bool addLine(uint16_t, const uint8_t*, uint8_t, bool);
 
 	// End of program text
 	Pointer _textEnd;
@@ -318,6 +688,16 @@ private:
 	Pointer _arraysEnd;
 	// Stack pointer
 	Pointer _sp;
+#if CONF_GOSUB_LINK
+	// Address of the last subprogram return frame, program size if none
+	Pointer _gosubSP;
+#endif
+#if CONF_EVAL_STACK
+	// Built-in functions arguments and results
+	Parser::Value _evalStack[EVAL_STACK_SIZE];
+	// Number of used slots, cleared with the stack pointer
+	uint8_t _evalDepth;
+#endif
 	// Position of main execution thread
 	Position _current;
 #if USE_DATA
@@ -328,6 +708,103 @@ private:
 	bool _jumpFlag;
 	// Jump pointer
 	Pointer _jump;
+#if CONF_LINE_INDEX
+	// Addresses of the indexed lines
+	Pointer _lineIndex[LINE_INDEX_SIZE];
+	// Number of used index entries
+	uint8_t _lineIndexCount;
+	// Number of lines, covered by one index entry, 0 if index is invalid
+	uint16_t _lineIndexStep;
+#endif
+#if FAST_LINE_JUMP
+	// Resolved line addresses in program text are valid
+	bool _linked;
+#endif
+#if FAST_VARIABLE_ACCESS
+	// Resolved variable frame addresses in program text are valid
+	bool _variablesBound;
+#endif
+#if CONF_FAST_FOR_NEXT || CONF_BYTECODE
+	// Variables layout stamp, changed if variable frames are moved
+	uint16_t _variablesLayout;
+#endif
+#if CONF_TEXT_GAP
+	// Start of the editing gap in program text
+	Pointer _gapStart;
+	// Size of the editing gap, 0 if gap is closed
+	Pointer _gapSize;
+#endif
+#if CONF_FAST_APPEND
+	// Number of the last program line
+	uint16_t _lastNumber;
+	// Last line number is valid
+	bool _lastKnown;
+#endif
+#if CONF_LINE_CACHE
+	/**
+	 * @brief Cached copy of the program line body
+	 */
+	struct LineCacheEntry
+	{
+		// Line address, LINE_NOT_CACHED if entry is free
+		Pointer index;
+		// Time of the last access
+		uint16_t stamp;
+		// Line header and body
+		uint8_t line[sizeof(Line) + LINE_CACHE_LINESIZE];
+	};
+	static const Pointer LINE_NOT_CACHED = Pointer(~Pointer(0));
+	LineCacheEntry _lineCache[LINE_CACHE_SIZE];
+	// Line cache access counter
+	uint16_t _lineCacheClock;
+	// Entry of the line being parsed or LINE_CACHE_SIZE
+	uint8_t _lineCachePinned;
+#endif
+#if CONF_VARIABLE_INDEX
+	static const Pointer VARIABLE_NOT_INDEXED = Pointer(~Pointer(0));
+	// Variable frame addresses, relative to the text end
+	Pointer _variableIndex[VARIABLE_INDEX_SIZE];
+#endif
+#if CONF_ARRAY_CACHE
+	static const Pointer ARRAY_NOT_CACHED = Pointer(~Pointer(0));
+	ArrayDescriptor _arrayCache[ARRAY_CACHE_SIZE];
+#endif
+#if CONF_FOR_SKIP_CACHE
+	/**
+	 * @brief Position after the NEXT statement of the zero-iteration loop
+	 */
+	struct ForSkipEntry
+	{
+		// Position after the FOR statement, index is FOR_NOT_CACHED if
+		// entry is free
+		Position loop;
+		// Position after the NEXT statement
+		Position next;
+	};
+	static const Pointer FOR_NOT_CACHED = Pointer(~Pointer(0));
+	ForSkipEntry _forSkipCache[FOR_SKIP_CACHE_SIZE];
+	// Position after the FOR statement of the loop, which body is being
+	// scanned, index is FOR_NOT_CACHED if there is no such loop
+	Position _skippedFor;
+#endif
+#if CONF_LINE_SKIP_CACHE
+	static const Pointer LINE_SKIP_NOT_CACHED = Pointer(~Pointer(0));
+	// Positions of the statements, which skip the rest of the line,
+	// index is LINE_SKIP_NOT_CACHED if entry is free
+	Position _lineSkipCache[LINE_SKIP_CACHE_SIZE];
+#endif
+#if CONF_BYTECODE
+	static const Pointer BYTECODE_NOT_CACHED = Pointer(~Pointer(0));
+	// Number of entries in the set of one position hash
+	static const uint8_t BYTECODE_WAYS = 2;
+	BytecodeEntry _bytecode[BYTECODE_CACHE_SIZE];
+#endif
+#if EXTMEMFS_STREAM
+	// External storage of the program text or nullptr
+	TextStorage *_storage;
+	// Size of the text in external storage
+	Pointer _storageEnd;
+#endif
 };
 
 } // namespace BASIC
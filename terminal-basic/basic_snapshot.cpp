@@ -0,0 +1,171 @@
+/*
+ * This file is part of Terminal-BASIC: a lightweight BASIC-like language
+ * interpreter.
+ * 
+ * Copyright (C) 2016-2018 Andrey V. Skvortsov <starling13@mail.ru>
+ * Copyright (C) 2019-2021 Terminal-BASIC team
+ *     <https://github.com/terminal-basic-team>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "basic_snapshot.hpp"
+
+#if CONF_MODULE_SNAPSHOT
+
+#include "basic_program.hpp"
+#if CONF_USE_EXTMEMFS
+#include "basic_extmemfs.hpp"
+#endif
+
+namespace BASIC
+{
+
+static const uint8_t snapshotCommands[] PROGMEM = {
+	'C', 'H', 'E', 'C', 'K', 'P', 'O', 'I', 'N', 'T', ASCII_NUL,
+	'R', 'E', 'S', 'U', 'M', 'E', ASCII_NUL,
+	ASCII_ETX
+};
+
+const FunctionBlock::command SnapshotModule::_commands[] PROGMEM = {
+	SnapshotModule::comm_checkpoint,
+	SnapshotModule::comm_resume
+#if FAST_MODULE_CALL
+	, nullptr
+#endif
+};
+
+#if HAL_NVRAM
+NVRAMStream::NVRAMStream(HAL_nvram_address_t address) :
+    m_address(address)
+{
+}
+
+int
+NVRAMStream::available()
+{
+	const HAL_nvram_address_t size = HAL_nvram_getsize();
+	return m_address < size ? size - m_address : 0;
+}
+
+size_t
+NVRAMStream::write(uint8_t byte)
+{
+	if (m_address >= HAL_nvram_getsize())
+		return 0;
+	HAL_nvram_write(m_address++, byte);
+	return 1;
+}
+
+void
+NVRAMStream::flush()
+{
+}
+
+int
+NVRAMStream::peek()
+{
+	if (m_address >= HAL_nvram_getsize())
+		return -1;
+	return HAL_nvram_read(m_address);
+}
+
+int
+NVRAMStream::read()
+{
+	if (m_address >= HAL_nvram_getsize())
+		return -1;
+	return HAL_nvram_read(m_address++);
+}
+#endif // HAL_NVRAM
+
+SnapshotModule::SnapshotModule()
+{
+	commands = _commands;
+	commandTokens = snapshotCommands;
+}
+
+#if CONF_USE_EXTMEMFS
+/**
+ * @brief Get snapshot file name from the stack
+ * @param i interpreter
+ * @param ss [out] file name
+ * @return flag of success
+ */
+static bool
+getFileName(Interpreter &i, char ss[])
+{
+	static const char strSNP[] PROGMEM = ".SNP";
+
+	const char *s;
+	if (!i.popString(s))
+		return false;
+
+	const uint8_t len = strlen(s);
+	if (len > 8)
+		return false;
+	strcpy(ss, s);
+	strcpy_P(ss + len, (PGM_P)strSNP);
+	return true;
+}
+#endif // CONF_USE_EXTMEMFS
+
+bool
+SnapshotModule::comm_checkpoint(Interpreter &i)
+{
+#if CONF_USE_EXTMEMFS
+	char ss[13];
+	if (!getFileName(i, ss))
+		return false;
+	HAL_extmem_deletefile(ss);
+	HAL_extmem_file_t f = HAL_extmem_openfile(ss);
+	if (f == 0)
+		return false;
+	FileStream fs(f);
+	const bool result = i.saveSnapshot(fs);
+	fs.close();
+	return result;
+#elif HAL_NVRAM
+	NVRAMStream s(SNAPSHOT_NVRAM_ADDRESS);
+	return i.saveSnapshot(s);
+#else
+	return false;
+#endif
+}
+
+bool
+SnapshotModule::comm_resume(Interpreter &i)
+{
+#if CONF_USE_EXTMEMFS
+	char ss[13];
+	if (!getFileName(i, ss) || !HAL_extmem_fileExists(ss))
+		return false;
+	HAL_extmem_file_t f = HAL_extmem_openfile(ss);
+	if (f == 0)
+		return false;
+	FileStream fs(f);
+	const bool result = i.loadSnapshot(fs);
+	fs.close();
+	return result;
+#elif HAL_NVRAM
+	NVRAMStream s(SNAPSHOT_NVRAM_ADDRESS);
+	return i.loadSnapshot(s);
+#else
+	return false;
+#endif
+}
+
+} // namespace BASIC
+
+#endif // CONF_MODULE_SNAPSHOT
@@ -0,0 +1,86 @@
+/*
+ * This file is part of Terminal-BASIC: a lightweight BASIC-like language
+ * interpreter.
+ * 
+ * Copyright (C) 2016-2018 Andrey V. Skvortsov <starling13@mail.ru>
+ * Copyright (C) 2019-2021 Terminal-BASIC team
+ *     <https://github.com/terminal-basic-team>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file basic_snapshot.hpp
+ * @brief Interpreter state snapshot module
+ */
+
+#ifndef BASIC_SNAPSHOT_HPP
+#define BASIC_SNAPSHOT_HPP
+
+#include "basic_functionblock.hpp"
+#include "basic_interpreter.hpp"
+
+#if CONF_MODULE_SNAPSHOT
+
+namespace BASIC
+{
+
+#if HAL_NVRAM
+/**
+ * @brief Sequential access to the NVRAM from the given address
+ */
+class NVRAMStream : public Stream
+{
+public:
+
+	explicit NVRAMStream(HAL_nvram_address_t);
+
+private:
+
+	HAL_nvram_address_t m_address;
+
+// Stream interface
+public:
+
+	int available() override;
+
+	size_t write(uint8_t) override;
+
+	void flush() override;
+
+	int peek() override;
+
+	int read() override;
+};
+#endif // HAL_NVRAM
+
+/**
+ * @brief Module with commands to save and restore interpreter state
+ */
+class SnapshotModule : public FunctionBlock
+{
+public:
+	explicit SnapshotModule();
+private:
+	static bool comm_checkpoint(Interpreter&);
+	static bool comm_resume(Interpreter&);
+	
+	static const FunctionBlock::command _commands[] PROGMEM;
+};
+
+} // namespace BASIC
+
+#endif // CONF_MODULE_SNAPSHOT
+
+#endif // BASIC_SNAPSHOT_HPP
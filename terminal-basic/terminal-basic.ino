@@ -34,6 +34,10 @@
 #include "basic_arduinoio.hpp"
 #endif
 
+#if CONF_MODULE_SNAPSHOT
+#include "basic_snapshot.hpp"
+#endif
+
 #if USEPS2USARTKB
 #include "ps2uartstream.hpp"
 #endif
@@ -127,6 +131,10 @@ static BASIC::Math mathBlock;
 static BASIC::ArduinoIO arduinoIo;
 #endif
 
+#if CONF_MODULE_SNAPSHOT
+static BASIC::SnapshotModule snapshotModule;
+#endif
+
 #if USE_EXTEEPROM
 static BASIC::ExtEEPROM extEeprom;
 #endif
@@ -244,6 +252,10 @@ setup()
 	basic.setSDFSModule(&sdfs);
 	basic.addModule(&sdfs);
 #endif
+
+#if CONF_MODULE_SNAPSHOT
+	basic.addModule(&snapshotModule);
+#endif
 	
 	basic.init();
 #if BASIC_MULTITERMINAL
@@ -44,6 +44,31 @@ tools_isAlphaNum(uint8_t c)
 	return isdigit(c) || tools_isAlpha(c);
 }
 
+uint16_t
+tools_crc16_update(uint16_t crc, uint8_t byte)
+{
+	uint8_t i;
+	
+	crc ^= byte;
+	for (i = 0; i < 8; ++i) {
+		if (crc & 1)
+			crc = (crc >> 1) ^ 0xA001;
+		else
+			crc >>= 1;
+	}
+	return crc;
+}
+
+uint16_t
+tools_crc16_buffer(uint16_t crc, const void *buf, size_t len)
+{
+	const uint8_t *b = (const uint8_t*)buf;
+	
+	while (len-- > 0)
+		crc = tools_crc16_update(crc, *(b++));
+	return crc;
+}
+
 void
 _ftoa(float f, char *buf)
 {
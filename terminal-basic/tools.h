@@ -25,6 +25,7 @@
 
 #include "sys/cdefs.h"
 #include <stdint.h>
+#include <stddef.h>
 
 __BEGIN_DECLS
 
@@ -46,6 +47,23 @@ BOOLEAN tools_isAlpha(uint8_t);
 
 BOOLEAN tools_isAlphaNum(uint8_t);
 
+/**
+ * @brief Update CRC-16 (polynomial 0xA001) checksum with the byte
+ * @param crc current checksum
+ * @param byte
+ * @return new checksum
+ */
+uint16_t tools_crc16_update(uint16_t, uint8_t);
+
+/**
+ * @brief Update CRC-16 checksum with the buffer
+ * @param crc current checksum
+ * @param buf
+ * @param len buffer length
+ * @return new checksum
+ */
+uint16_t tools_crc16_buffer(uint16_t, const void*, size_t);
+
 void _ftoa(float, char*);
 
 void _dtoa(double, char*);